@@ -4,14 +4,18 @@
 #include <vector>
 #include <algorithm>
 #include <chrono>
-#include <execution>
 
 #include "IModelEnginePartitioner.h"
+#include "IModelEngineBacklog.h"
 #include "ModelEngineCommon.h"
 #include "ModelEngineContext.h"
 #include "WorkerContextOp.h"
 #include "Worker.h"
 #include "WorkItem.h"
+#include "TimingWheel.h"
+#include "WorkItemSorter.h"
+#include "DenseFrontier.h"
+#include "HugePageAllocator.h"
 
 namespace embeddedpenguins::modelengine
 {
@@ -33,18 +37,28 @@ namespace embeddedpenguins::modelengine
     // within its 'stripe', but not to memory in other 'stripes'.
     //
     template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
-    class AdaptiveWidthPartitioner : public IModelEnginePartitioner
+    class AdaptiveWidthPartitioner : public IModelEnginePartitioner, public IModelEngineBacklog<OPERATORTYPE>
     {
         // Expose some internal state to derived classes to allow for testing.
     protected:
         ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context_;
         vector<WorkItem<OPERATORTYPE>> totalSourceWork_ {};
+        TimingWheel<OPERATORTYPE> futureWork_ {};
         vector<WorkItem<OPERATORTYPE>> workForNextTick_ {};
+        vector<WorkItem<OPERATORTYPE>> handedOffWork_ {};
+        vector<WorkItem<OPERATORTYPE>> dueWork_ {};
+        vector<vector<WorkItem<OPERATORTYPE>>*> sortedRuns_ {};
+        vector<unsigned long long int> segmentEnds_ {};
+        WorkItemSorter<OPERATORTYPE> sorter_ {};
+        DenseFrontier<OPERATORTYPE> frontier_ {};
+        bool dense_ { false };
+        HugePageAdvisor hugePageAdvisor_ {};
 
     public:
         AdaptiveWidthPartitioner(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context) :
             context_(context)
         {
+            context_.Backlog = this;
         }
 
         //
@@ -55,8 +69,7 @@ namespace embeddedpenguins::modelengine
         virtual void ConcurrentPartitionStep() override
         {
 #ifndef NOLOG
-            context_.Logger.Logger() << "Tick " << context_.Iterations << ": Accumulating future work from all workers and Splitting out work for next tick\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("Tick {}: Accumulating future work from all workers and Splitting out work for next tick\n", context_.Iterations);
 #endif
 
             AccumulateFutureWorkFromAllWorkers();
@@ -70,19 +83,65 @@ namespace embeddedpenguins::modelengine
         virtual unsigned long int SingleThreadPartitionStep() override
         {
 #ifndef NOLOG
-            context_.Logger.Logger() << "Tick " << context_.Iterations << ": Accumulating next tick work from all workers and partitioning to all workers\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("Tick {}: Accumulating next tick work from all workers and partitioning to all workers\n", context_.Iterations);
 #endif
 
+            dense_ = ShouldUseDenseFrontier();
+            PresortNextTick(!dense_);
+            if (dense_)
+            {
+                ScatterWorkForNextTickIntoFrontier();
+                return PartitionFrontierToAllWorkers();
+            }
+
             AccumulateWorkForNextTickFromAllWorkers();
             return PartitionWorkForNextTickToAllWorkers();
         }
 
+        virtual unsigned long long int BacklogSize() override
+        {
+            return totalSourceWork_.size() + futureWork_.Size();
+        }
+
+        virtual unsigned long long int NextScheduledTick() override
+        {
+            auto nextTick = futureWork_.EarliestTick();
+            for (auto& work : totalSourceWork_)
+                if (work.Tick < nextTick) nextTick = work.Tick;
+
+            return nextTick;
+        }
+
+        virtual void ExportBacklog(vector<WorkItem<OPERATORTYPE>>& backlog) override
+        {
+            backlog.insert(end(backlog), begin(totalSourceWork_), end(totalSourceWork_));
+            futureWork_.CopyTo(backlog);
+        }
+
+        virtual void ExportWorkForTick(vector<WorkItem<OPERATORTYPE>>& workForTick) override
+        {
+            if (dense_) frontier_.CopyTo(workForTick);
+        }
+
+        virtual void ImportPendingWork(const vector<WorkItem<OPERATORTYPE>>& workForTick, const vector<WorkItem<OPERATORTYPE>>& backlog) override
+        {
+            dense_ = false;
+            futureWork_.StartAt(context_.Iterations);
+            for (auto& work : backlog)
+                futureWork_.Insert(work);
+
+            workForNextTick_.assign(begin(workForTick), end(workForTick));
+            sorter_.SortByIndex(workForNextTick_, context_.Helper.Model().ModelSize());
+            if (context_.CoalesceWork)
+                sorter_.Coalesce(workForNextTick_);
+            PartitionWorkForNextTickToAllWorkers();
+        }
+
         // Expose some internal methods to derived classes to allow for testing.
     protected:
         //
         // Accumulate all future work (work that is scheduled later than the upcoming tick)
-        // from all worker threads, as it was created in the previous tick, into the work backlog.  
+        // from all worker threads, as it was created in the previous tick, into the work intake.  
         // In the current tick, the worker threads are using the current buffer, 
         // so the other buffer is free for us to access read/write.
         // NOTE: This may run concurrently with the worker threads.
@@ -115,8 +174,10 @@ namespace embeddedpenguins::modelengine
         }
 
         //
-        // The work backlog has work from all previous ticks, scheduled for a specific tick.
-        // Collect any work scheduled for the next tick, and split it out from the work backlog.
+        // The work intake has work created in the previous tick, and the timing wheel
+        // has work from all earlier ticks, each scheduled for a specific tick.
+        // Collect any work scheduled for the next tick from both, scheduling the
+        // remainder of the intake into the timing wheel.
         // NOTE: This may run concurrently with the worker threads.
         //
         void SplitOutWorkForNextTick()
@@ -128,40 +189,54 @@ namespace embeddedpenguins::modelengine
                 end(workForNextTick_), 
                 begin(totalSourceWork_), 
                 cutoffPoint);
-            totalSourceWork_.erase(begin(totalSourceWork_), cutoffPoint);
+
+            for (auto work = cutoffPoint; work != end(totalSourceWork_); work++)
+                futureWork_.Insert(*work);
+            totalSourceWork_.clear();
+
+            futureWork_.ExtractDueWork(context_.Iterations + 1, workForNextTick_);
         }
 
         //
         // Accumulate all next-tick work from all worker threads, as it was created in the 
         // just-completed current tick.  There is only one buffer per worker thread for next-tick
-        // work.
+        // work, and each worker has already sorted it by index as the last step of its scan.
+        // Sort the smaller runs of split-out future work and external work, then
+        // merge all runs into the work for next tick, grouped by index, and
+        // combine work for the same index where the operation type allows.
         // NOTE: This MUST NOT run concurrently with the worker threads.
         //
         void AccumulateWorkForNextTickFromAllWorkers()
         {
+            auto indexLimit = context_.Helper.Model().ModelSize();
+
+            dueWork_.swap(workForNextTick_);
+            sorter_.SortByIndex(dueWork_, indexLimit);
+            sortedRuns_.clear();
+            sortedRuns_.push_back(&dueWork_);
+
             for (auto& worker : context_.Workers)
             {
                 auto& workForTick1 = worker->GetContext().WorkForTick1;
-                workForNextTick_.insert(
-                    end(workForNextTick_), 
-                    begin(workForTick1), 
-                    end(workForTick1));
-
-                workForTick1.clear();
+                if (!IsSortedByIndex(workForTick1))
+                    sorter_.SortByIndex(workForTick1, indexLimit);
+                sortedRuns_.push_back(&workForTick1);
             }
 
             auto& externalworkForTick1 = context_.ExternalWorkSource.WorkForTick1;
-            workForNextTick_.insert(
-                end(workForNextTick_), 
-                begin(externalworkForTick1), 
-                end(externalworkForTick1));
+            sorter_.SortByIndex(externalworkForTick1, indexLimit);
+            sortedRuns_.push_back(&externalworkForTick1);
 
-            externalworkForTick1.clear();
+            sorter_.MergeRuns(sortedRuns_, workForNextTick_);
+            for (auto* run : sortedRuns_)
+                run->clear();
+
+            if (context_.CoalesceWork)
+                sorter_.Coalesce(workForNextTick_);
 #ifndef NOLOG
             if (!workForNextTick_.empty())
             {
-                context_.Logger.Logger() << "Partitioning found " << workForNextTick_.size() << " work items for tick " << context_.Iterations + 1 << ", leaving " << totalSourceWork_.size() << " for future ticks\n";
-                context_.Logger.Logit();
+                context_.Logger.Write("Partitioning found {} work items for tick {}, leaving {} for future ticks\n", workForNextTick_.size(), context_.Iterations + 1, futureWork_.Size());
             }
 #endif
         }
@@ -169,8 +244,8 @@ namespace embeddedpenguins::modelengine
         //
         // The work for next tick contains work from all previous ticks split
         // out from the work backlog, plus any work newly-generated by the workers
-        // in the current tick.
-        // Sort by index and partition to workers for next tick.
+        // in the current tick, already grouped by index.
+        // Partition to workers for next tick, as ranges of this buffer.
         // NOTE: This MUST NOT run concurrently with the worker threads.
         //
         unsigned long int PartitionWorkForNextTickToAllWorkers()
@@ -179,41 +254,179 @@ namespace embeddedpenguins::modelengine
             context_.TotalWork += totalWork;
 
 #ifndef NOLOG
-            context_.Logger.Logger() << "PartitionWorkForNextTickToAllWorkers starting sort\n";
-            context_.Logger.Logit();
-#endif
-            std::sort(
-                std::execution::par,
-                begin(workForNextTick_), 
-                end(workForNextTick_) , 
-                [](const WorkItem<OPERATORTYPE>& lhs, const WorkItem<OPERATORTYPE>& rhs){ 
-                    return lhs.Operator.Index < rhs.Operator.Index;
-            });
-
-#ifndef NOLOG
-            context_.Logger.Logger() << "PartitionWorkForNextTickToAllWorkers allocating segments to worker threads\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("PartitionWorkForNextTickToAllWorkers allocating segments to worker threads\n");
 #endif
 
-            auto segmentSize = workForNextTick_.size() / context_.WorkerCount;
-            if (segmentSize < 1) segmentSize = 1;
+            FindSegmentEnds(workForNextTick_, segmentEnds_);
 
             auto segmentBegin = begin(workForNextTick_);
 
             for (auto workerIndex = 0; workerIndex < context_.Workers.size(); workerIndex++)
             {
-                auto segmentEnd = FindSegmentEnd(workForNextTick_, segmentSize, segmentBegin, workerIndex);
+                auto segmentEnd = begin(workForNextTick_) + segmentEnds_[workerIndex];
 
                 auto& targetWorker = context_.Workers[workerIndex];
                 WorkerContextOp<OPERATORTYPE, RECORDTYPE> contextOp(targetWorker->GetContext());
                 contextOp.CaptureWorkForThread(segmentBegin, segmentEnd);
+                if (context_.WorkStealing)
+                    contextOp.SplitWorkIntoChunks(context_.ChunksPerWorker);
 
                 segmentBegin = segmentEnd;
             }
 
+            // The workers now hold ranges of this buffer, so keep it aside for the
+            // next tick while the other one collects work for the tick after.
+            // Swapping vectors leaves the ranges valid.
+            handedOffWork_.swap(workForNextTick_);
+            if (context_.HugePageWorkBuffers)
+            {
+                hugePageAdvisor_.Advise(handedOffWork_);
+                hugePageAdvisor_.Advise(totalSourceWork_);
+            }
+
+            return totalWork;
+        }
+
+        //
+        // Choose dense or sparse work for the next tick, as Ligra does, by how
+        // much of the model it covers.  When a large fraction of the model is
+        // active, scattering the work into a bitmap of the model and sweeping
+        // it costs less than sorting and merging lists of work items.
+        // Derived partitioners that cut the work by more than index may opt out.
+        //
+        virtual bool DenseFrontierAllowed() const
+        {
+            return true;
+        }
+
+        bool ShouldUseDenseFrontier()
+        {
+            auto modelSize = context_.Helper.Model().ModelSize();
+            if (context_.DenseFrontierFraction <= 0.0 || context_.WorkStealing || modelSize == 0 || !DenseFrontierAllowed()) return false;
+
+            auto incomingWork = workForNextTick_.size() + context_.ExternalWorkSource.WorkForTick1.size();
+            for (auto& worker : context_.Workers)
+                incomingWork += worker->GetContext().WorkForTick1.size();
+
+            return incomingWork > 0 && incomingWork >= context_.DenseFrontierFraction * modelSize;
+        }
+
+        //
+        // Workers sort their next-tick work only for a sparse tick.  Activity
+        // changes slowly, so whether this tick is dense predicts the next.
+        //
+        void PresortNextTick(bool presort)
+        {
+            if (!DenseFrontierAllowed()) return;
+
+            auto indexLimit = presort ? static_cast<unsigned long long int>(context_.Helper.Model().ModelSize()) : 0ULL;
+            for (auto& worker : context_.Workers)
+                worker->GetContext().PresortIndexLimit = indexLimit;
+        }
+
+        //
+        // Scatter the due work, then the next-tick work of each worker, then
+        // external work, into the frontier, so work for the same index keeps
+        // the order it would have from merging.
+        // NOTE: This MUST NOT run concurrently with the worker threads.
+        //
+        void ScatterWorkForNextTickIntoFrontier()
+        {
+            frontier_.Resize(context_.Helper.Model().ModelSize());
+            frontier_.StartInserting();
+
+            auto combine = context_.CoalesceWork;
+            for (auto& work : workForNextTick_)
+                frontier_.Insert(work, combine);
+            workForNextTick_.clear();
+
+            for (auto& worker : context_.Workers)
+            {
+                auto& workForTick1 = worker->GetContext().WorkForTick1;
+                for (auto& work : workForTick1)
+                    frontier_.Insert(work, combine);
+                workForTick1.clear();
+            }
+
+            auto& externalworkForTick1 = context_.ExternalWorkSource.WorkForTick1;
+            for (auto& work : externalworkForTick1)
+                frontier_.Insert(work, combine);
+            externalworkForTick1.clear();
+
+            frontier_.FinishInserting(sorter_);
+#ifndef NOLOG
+            context_.Logger.Write("Partitioning found {} work items for tick {} and holds them densely, leaving {} for future ticks\n", frontier_.Count(), context_.Iterations + 1, futureWork_.Size());
+#endif
+        }
+
+        //
+        // Give each worker a stripe of the frontier, cut between words of its
+        // bitmap so that each stripe has about the same number of active nodes.
+        // NOTE: This MUST NOT run concurrently with the worker threads.
+        //
+        unsigned long int PartitionFrontierToAllWorkers()
+        {
+            auto totalWork = frontier_.Count();
+            context_.TotalWork += totalWork;
+
+            auto wordCount = frontier_.WordCount();
+            auto activeNodes { 0ULL };
+            for (auto word = 0ULL; word < wordCount; word++)
+                activeNodes += frontier_.ActiveInWord(word);
+
+            auto workerCount = context_.Workers.size();
+            auto word { 0ULL };
+            auto seen { 0ULL };
+            auto firstWord { 0ULL };
+            for (auto workerIndex = 0ULL; workerIndex < workerCount; workerIndex++)
+            {
+                auto target = activeNodes * (workerIndex + 1) / workerCount;
+                while (word < wordCount && seen < target)
+                    seen += frontier_.ActiveInWord(word++);
+                auto lastWord = (workerIndex == workerCount - 1) ? wordCount : word;
+
+                WorkerContextOp<OPERATORTYPE, RECORDTYPE> contextOp(context_.Workers[workerIndex]->GetContext());
+                contextOp.CaptureFrontierForThread(frontier_, firstWord, lastWord);
+                firstWord = lastWord;
+            }
+
             return totalWork;
         }
 
+        //
+        // Cut the work for next tick into one segment for each worker, each
+        // ending at an offset into the work, with about the same number of
+        // work items in each.  An index is never split between segments.
+        //
+        virtual void FindSegmentEnds(vector<WorkItem<OPERATORTYPE>>& workForTimeSlice, vector<unsigned long long int>& segmentEnds)
+        {
+            auto segmentSize = workForTimeSlice.size() / context_.WorkerCount;
+            if (segmentSize < 1) segmentSize = 1;
+
+            segmentEnds.clear();
+            auto segmentBegin = begin(workForTimeSlice);
+            for (auto workerIndex = 0ULL; workerIndex < context_.Workers.size(); workerIndex++)
+            {
+                auto segmentEnd = FindSegmentEnd(workForTimeSlice, segmentSize, segmentBegin, workerIndex);
+                segmentEnds.push_back(segmentEnd - begin(workForTimeSlice));
+                segmentBegin = segmentEnd;
+            }
+        }
+
+        bool IsSortedByIndex(const vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            return std::is_sorted(
+                begin(work), 
+                end(work), 
+                [](const WorkItem<OPERATORTYPE>& lhs, const WorkItem<OPERATORTYPE>& rhs){
+                    return lhs.Operator.Index < rhs.Operator.Index;
+            });
+        }
+
+        //
+        // Partition the work intake so that work due before the next tick
+        // comes first, and return the end of that due work.
+        //
         typename vector<WorkItem<OPERATORTYPE>>::iterator FindCutoffPoint()
         {
             auto workCutoffTick = context_.Iterations + 1;
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ModelEngineContextOp.h"
+#include "IModelEngineWaiter.h"
+
+namespace embeddedpenguins::modelengine
+{
+    //
+    // This waiter is typically used for offline runs, such as parameter
+    // sweeps, where model time need not track wall-clock time.  It never
+    // sleeps, so each tick starts as soon as the previous one is done.
+    //
+    template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
+    class AsFastAsPossibleWaiter : public IModelEngineWaiter
+    {
+        ModelEngineContextOp<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE> contextOp_;
+
+    public:
+        AsFastAsPossibleWaiter(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context) :
+            contextOp_(context)
+        {
+
+        }
+
+        virtual bool WaitForWorkOrQuit() override
+        {
+            return contextOp_.QuitRequested();
+        }
+    };
+}
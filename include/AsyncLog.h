@@ -0,0 +1,406 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <sstream>
+#include <condition_variable>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace embeddedpenguins::modelengine
+{
+    using std::string;
+    using std::string_view;
+    using std::vector;
+    using std::unique_ptr;
+    using std::atomic;
+    using std::mutex;
+    using std::lock_guard;
+    using std::unique_lock;
+    using std::thread;
+    using std::condition_variable;
+    using std::chrono::milliseconds;
+
+    constexpr std::size_t DefaultLogRingBytes { 256 * 1024 };
+    constexpr std::size_t LogWriteBatchBytes { 1024 * 1024 };
+    constexpr milliseconds DefaultLogDrainInterval { 1 };
+
+    //
+    // How one argument of a log message is copied into a log ring, and
+    // read back out for formatting.  Trivially copyable values are copied
+    // as they are; strings are copied with their length, so the caller's
+    // buffer may change as soon as the message is written.
+    //
+    template<class ARGUMENTTYPE, class = void>
+    struct LogArgument
+    {
+        static_assert(std::is_trivially_copyable_v<ARGUMENTTYPE>, "Log arguments must be strings or trivially copyable");
+
+        static std::size_t Size(const ARGUMENTTYPE&) { return sizeof(ARGUMENTTYPE); }
+
+        static void Encode(char*& buffer, const ARGUMENTTYPE& argument)
+        {
+            std::memcpy(buffer, &argument, sizeof(ARGUMENTTYPE));
+            buffer += sizeof(ARGUMENTTYPE);
+        }
+
+        static ARGUMENTTYPE Decode(const char*& buffer)
+        {
+            ARGUMENTTYPE argument;
+            std::memcpy(&argument, buffer, sizeof(ARGUMENTTYPE));
+            buffer += sizeof(ARGUMENTTYPE);
+            return argument;
+        }
+    };
+
+    struct LogStringArgument
+    {
+        static std::size_t Size(string_view argument) { return sizeof(std::size_t) + argument.size(); }
+
+        static void Encode(char*& buffer, string_view argument)
+        {
+            auto length = argument.size();
+            std::memcpy(buffer, &length, sizeof(length));
+            std::memcpy(buffer + sizeof(length), argument.data(), length);
+            buffer += sizeof(length) + length;
+        }
+
+        static string_view Decode(const char*& buffer)
+        {
+            std::size_t length;
+            std::memcpy(&length, buffer, sizeof(length));
+            string_view argument(buffer + sizeof(length), length);
+            buffer += sizeof(length) + length;
+            return argument;
+        }
+    };
+
+    template<> struct LogArgument<const char*> : LogStringArgument { };
+    template<> struct LogArgument<char*> : LogStringArgument { };
+    template<> struct LogArgument<string> : LogStringArgument { };
+    template<> struct LogArgument<string_view> : LogStringArgument { };
+
+    //
+    // A log written by one thread and drained by another, in the manner of
+    // NanoLog: writing a message copies only a pointer to its static format
+    // string and its raw arguments into a ring of fixed size, and all
+    // formatting is left to the thread that drains the ring.
+    // Formats use {} for each argument, in order.
+    // Writing never blocks and never allocates.  A message that does not
+    // fit in the free space of the ring is dropped and counted.
+    //
+    class AsyncLog
+    {
+        using DecodeFunction = void (*)(const char* format, const char* arguments, std::ostringstream& stream);
+
+        struct EntryHeader
+        {
+            std::size_t Size;
+            DecodeFunction Decode;
+            const char* Format;
+        };
+
+        static constexpr std::size_t EntryAlignment { alignof(EntryHeader) };
+
+        unique_ptr<char[]> ring_ {};
+        std::size_t capacity_ { 0 };
+        int id_ { 0 };
+        alignas(64) atomic<std::size_t> head_ { 0 };
+        std::size_t cachedTail_ { 0 };
+        alignas(64) atomic<std::size_t> tail_ { 0 };
+        atomic<unsigned long long int> dropped_ { 0ULL };
+
+    public:
+        AsyncLog(std::size_t ringBytes = DefaultLogRingBytes) :
+            capacity_(RoundUpToPowerOfTwo(ringBytes))
+        {
+            ring_ = unique_ptr<char[]>(new char[capacity_]);
+        }
+
+        AsyncLog(const AsyncLog&) = delete;
+        AsyncLog& operator=(const AsyncLog&) = delete;
+
+        void SetId(int id) { id_ = id; }
+        const int Id() const { return id_; }
+        const unsigned long long int Dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+        //
+        // Queue a message.  Only the thread owning this log may write to it,
+        // and the format must be a string literal, or otherwise outlive the log.
+        //
+        template<class... ARGUMENTTYPES>
+        void Write(const char* format, const ARGUMENTTYPES&... arguments)
+        {
+            auto bytes = RoundUp(sizeof(EntryHeader) + (static_cast<std::size_t>(0) + ... + LogArgument<std::decay_t<ARGUMENTTYPES>>::Size(arguments)));
+            auto* entry = Reserve(bytes);
+            if (entry == nullptr)
+            {
+                dropped_.fetch_add(1ULL, std::memory_order_relaxed);
+                return;
+            }
+
+            auto* header = reinterpret_cast<EntryHeader*>(entry);
+            header->Size = bytes;
+            header->Decode = &DecodeEntry<std::decay_t<ARGUMENTTYPES>...>;
+            header->Format = format;
+
+            [[maybe_unused]] auto* buffer = entry + sizeof(EntryHeader);
+            (LogArgument<std::decay_t<ARGUMENTTYPES>>::Encode(buffer, arguments), ...);
+
+            head_.store(head_.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+        }
+
+        //
+        // Format every queued message onto the end of the given string, and
+        // free its space in the ring.  Only one thread may drain a log.
+        // Return whether anything was drained.
+        //
+        bool Drain(string& out)
+        {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            auto head = head_.load(std::memory_order_acquire);
+            if (tail == head) return false;
+
+            std::ostringstream stream;
+            while (tail != head)
+            {
+                auto offset = tail & (capacity_ - 1);
+                if (capacity_ - offset < sizeof(EntryHeader))
+                {
+                    tail += capacity_ - offset;
+                    continue;
+                }
+
+                auto* header = reinterpret_cast<const EntryHeader*>(ring_.get() + offset);
+                if (header->Decode != nullptr)
+                {
+                    stream.str("");
+                    header->Decode(header->Format, ring_.get() + offset + sizeof(EntryHeader), stream);
+                    out += std::to_string(id_);
+                    out += ": ";
+                    out += stream.str();
+                }
+                tail += header->Size;
+            }
+
+            tail_.store(tail, std::memory_order_release);
+            return true;
+        }
+
+    private:
+        //
+        // Find room for an entry in one contiguous piece, skipping to the
+        // start of the ring if it would otherwise wrap.
+        //
+        char* Reserve(std::size_t bytes)
+        {
+            auto head = head_.load(std::memory_order_relaxed);
+            auto offset = head & (capacity_ - 1);
+            auto contiguous = capacity_ - offset;
+            auto needed = bytes + (contiguous < bytes ? contiguous : 0);
+            if (bytes > capacity_ / 2) return nullptr;
+
+            if (head + needed - cachedTail_ > capacity_)
+            {
+                cachedTail_ = tail_.load(std::memory_order_acquire);
+                if (head + needed - cachedTail_ > capacity_) return nullptr;
+            }
+
+            if (contiguous < bytes)
+            {
+                if (contiguous >= sizeof(EntryHeader))
+                {
+                    auto* padding = reinterpret_cast<EntryHeader*>(ring_.get() + offset);
+                    padding->Size = contiguous;
+                    padding->Decode = nullptr;
+                }
+                head_.store(head + contiguous, std::memory_order_release);
+                offset = 0;
+            }
+
+            return ring_.get() + offset;
+        }
+
+        template<class... ARGUMENTTYPES>
+        static void DecodeEntry(const char* format, [[maybe_unused]] const char* arguments, std::ostringstream& stream)
+        {
+            (FormatNext(stream, format, LogArgument<ARGUMENTTYPES>::Decode(arguments)), ...);
+            stream << format;
+        }
+
+        template<class VALUETYPE>
+        static void FormatNext(std::ostringstream& stream, const char*& format, const VALUETYPE& value)
+        {
+            auto* placeholder = std::strstr(format, "{}");
+            if (placeholder == nullptr)
+            {
+                stream << format << ' ' << value;
+                format += std::strlen(format);
+                return;
+            }
+
+            stream.write(format, placeholder - format);
+            stream << value;
+            format = placeholder + 2;
+        }
+
+        static std::size_t RoundUp(std::size_t bytes)
+        {
+            return (bytes + EntryAlignment - 1) & ~(EntryAlignment - 1);
+        }
+
+        static std::size_t RoundUpToPowerOfTwo(std::size_t bytes)
+        {
+            std::size_t capacity { 1024 };
+            while (capacity < bytes) capacity <<= 1;
+            return capacity;
+        }
+    };
+
+    //
+    // Drain a set of logs to a file on a thread of its own, continuously
+    // while the model runs, so no log is held in memory until shutdown.
+    // Messages are formatted here, and written in large batches with pwrite().
+    // Messages of one log stay in order; messages of different logs are
+    // interleaved as they are drained, each line starting with its log's id.
+    //
+    class LogSink
+    {
+        string path_ {};
+        int fileDescriptor_ { -1 };
+        off_t offset_ { 0 };
+        string batch_ {};
+        bool failed_ { false };
+        milliseconds interval_ { DefaultLogDrainInterval };
+
+        mutex mutex_ {};
+        condition_variable cv_ {};
+        vector<AsyncLog*> logs_ {};
+        bool stop_ { false };
+        thread thread_ {};
+
+    public:
+        LogSink() = default;
+        LogSink(const LogSink&) = delete;
+        LogSink& operator=(const LogSink&) = delete;
+
+        ~LogSink()
+        {
+            Close();
+        }
+
+        const string& Path() const { return path_; }
+        const bool IsOpen() const { return fileDescriptor_ >= 0; }
+        const bool Failed() const { return failed_; }
+
+        bool Open(const string& path, milliseconds interval = DefaultLogDrainInterval)
+        {
+            if (IsOpen()) return false;
+
+            path_ = path;
+            fileDescriptor_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fileDescriptor_ < 0) return false;
+
+            offset_ = 0;
+            interval_ = interval;
+            batch_.clear();
+            batch_.reserve(LogWriteBatchBytes * 2);
+            stop_ = false;
+            thread_ = thread([this]() { Drain(); });
+
+            return true;
+        }
+
+        //
+        // Start draining a log.  Anything already written to it is drained too.
+        //
+        void Attach(AsyncLog& log)
+        {
+            lock_guard<mutex> lock(mutex_);
+            logs_.push_back(&log);
+        }
+
+        //
+        // Drain every log a last time, note any dropped messages,
+        // then stop and close the file.  Logs are detached.
+        //
+        void Close()
+        {
+            if (!thread_.joinable()) return;
+
+            {
+                lock_guard<mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            thread_.join();
+
+            for (auto* log : logs_)
+                if (log->Dropped() > 0)
+                    batch_ += std::to_string(log->Id()) + ": " + std::to_string(log->Dropped()) + " messages dropped\n";
+            WriteBatch();
+            logs_.clear();
+
+            close(fileDescriptor_);
+            fileDescriptor_ = -1;
+        }
+
+    private:
+        void Drain()
+        {
+            vector<AsyncLog*> logs;
+            auto stopping { false };
+            while (!stopping)
+            {
+                {
+                    unique_lock<mutex> lock(mutex_);
+                    cv_.wait_for(lock, interval_, [this]() { return stop_; });
+                    stopping = stop_;
+                    logs = logs_;
+                }
+
+                for (auto* log : logs)
+                {
+                    log->Drain(batch_);
+                    if (batch_.size() >= LogWriteBatchBytes)
+                        WriteBatch();
+                }
+
+                WriteBatch();
+            }
+        }
+
+        void WriteBatch()
+        {
+            auto* data = batch_.data();
+            auto remaining = batch_.size();
+            while (remaining > 0 && !failed_)
+            {
+                auto written = pwrite(fileDescriptor_, data, remaining, offset_);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    failed_ = true;
+                    break;
+                }
+
+                data += written;
+                remaining -= written;
+                offset_ += written;
+            }
+
+            batch_.clear();
+        }
+    };
+}
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <tuple>
+#include <fstream>
+#include <functional>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+namespace embeddedpenguins::modelengine
+{
+    using std::string;
+    using std::vector;
+    using std::tuple;
+    using std::ifstream;
+    using std::ofstream;
+
+    enum class RecordFormat
+    {
+        Csv,
+        Binary
+    };
+
+    constexpr char RecordFileMagic[8] { 'M', 'E', 'R', 'E', 'C', 'O', 'R', 'D' };
+    constexpr unsigned int RecordFormatVersion { 1 };
+    constexpr unsigned int RecordBlockMagic { 0x4b4c4252 };
+
+    //
+    // The binary record file starts with this header, followed by one
+    // entry for each column, and then any number of blocks.
+    //
+    struct RecordFileHeader
+    {
+        char Magic[8] { };
+        unsigned int Version { RecordFormatVersion };
+        unsigned int RecordBytes { 0 };
+        unsigned int ColumnCount { 0 };
+        unsigned int Reserved { 0 };
+    };
+
+    struct RecordColumnEntry
+    {
+        unsigned int Offset { 0 };
+        unsigned int Width { 0 };
+    };
+
+    //
+    // Each block holds the records of one recorder block, column by column:
+    // the ticks and the node indexes as zigzag varints of the difference
+    // from the row before, then every other column as packed fixed-width values.
+    //
+    struct RecordBlockHeader
+    {
+        unsigned int Magic { RecordBlockMagic };
+        unsigned int RecordCount { 0 };
+        unsigned int TickBytes { 0 };
+        unsigned int IndexBytes { 0 };
+        unsigned long long int ColumnBytes { 0ULL };
+    };
+
+    //
+    // A record type opts in to the binary format with a static Columns()
+    // returning a tuple of pointers to its data members.  The first member
+    // is the node index, and must be an integer.  The type must be trivially
+    // copyable, and any member not listed is read back as zero.
+    //
+    //     static constexpr auto Columns() { return std::make_tuple(&LifeRecord::LifeIndex, &LifeRecord::Type, &LifeRecord::Alive); }
+    //
+    template<class RECORDTYPE, class = void>
+    struct HasRecordColumns : std::false_type { };
+
+    template<class RECORDTYPE>
+    struct HasRecordColumns<RECORDTYPE, std::void_t<decltype(RECORDTYPE::Columns())>> : std::bool_constant<std::is_trivially_copyable_v<RECORDTYPE>> { };
+
+    //
+    // A binary record file is written in place of the CSV file of the same name.
+    //
+    inline string BinaryRecordPath(const string& recordPath)
+    {
+        const string csvExtension { ".csv" };
+        if (recordPath.size() >= csvExtension.size() && recordPath.compare(recordPath.size() - csvExtension.size(), csvExtension.size(), csvExtension) == 0)
+            return recordPath.substr(0, recordPath.size() - csvExtension.size()) + ".rec";
+
+        return recordPath + ".rec";
+    }
+
+    //
+    // Encode and decode blocks of records in the binary record format,
+    // and convert a binary record file to the CSV layout of the record type.
+    //
+    template<class RECORDTYPE>
+    class BinaryRecordFormat
+    {
+        static_assert(HasRecordColumns<RECORDTYPE>::value, "The record type needs a static Columns() and must be trivially copyable");
+
+        static constexpr auto columns_ { RECORDTYPE::Columns() };
+        static constexpr auto columnCount_ { std::tuple_size_v<std::decay_t<decltype(RECORDTYPE::Columns())>> };
+
+    public:
+        static void EncodeFileHeader(string& out)
+        {
+            RecordFileHeader header {};
+            std::memcpy(header.Magic, RecordFileMagic, sizeof(header.Magic));
+            header.RecordBytes = sizeof(RECORDTYPE);
+            header.ColumnCount = columnCount_;
+            Append(out, &header, sizeof(header));
+
+            auto columnEntries = ColumnEntries();
+            Append(out, columnEntries.data(), columnEntries.size() * sizeof(RecordColumnEntry));
+        }
+
+        static void EncodeBlock(const vector<tuple<unsigned long long int, RECORDTYPE>>& records, string& out)
+        {
+            auto headerPosition = out.size();
+            out.resize(out.size() + sizeof(RecordBlockHeader));
+
+            RecordBlockHeader header {};
+            header.RecordCount = records.size();
+
+            auto columnStart = out.size();
+            unsigned long long int previousTick { 0ULL };
+            for (auto& [tick, record] : records)
+            {
+                AppendVarint(out, ZigZag(static_cast<long long int>(tick - previousTick)));
+                previousTick = tick;
+            }
+            header.TickBytes = out.size() - columnStart;
+
+            columnStart = out.size();
+            unsigned long long int previousIndex { 0ULL };
+            for (auto& [tick, record] : records)
+            {
+                auto index = static_cast<unsigned long long int>(record.*std::get<0>(columns_));
+                AppendVarint(out, ZigZag(static_cast<long long int>(index - previousIndex)));
+                previousIndex = index;
+            }
+            header.IndexBytes = out.size() - columnStart;
+
+            columnStart = out.size();
+            out.resize(columnStart + records.size() * FixedRowBytes());
+            auto* column = out.data() + columnStart;
+            EncodeFixedColumns(records, column, std::make_index_sequence<columnCount_>{});
+            header.ColumnBytes = out.size() - columnStart;
+
+            std::memcpy(out.data() + headerPosition, &header, sizeof(header));
+        }
+
+        //
+        // Read every record of a binary record file in order, and return
+        // false if the file is missing, was written for another record type, or is cut short.
+        //
+        static bool ReadFile(const string& path, const std::function<void(unsigned long long int, RECORDTYPE&)>& forEachRecord)
+        {
+            ifstream file(path, std::ios::binary);
+            if (!file) return false;
+
+            RecordFileHeader header {};
+            if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+            if (std::memcmp(header.Magic, RecordFileMagic, sizeof(header.Magic)) != 0 || header.Version != RecordFormatVersion) return false;
+            if (header.RecordBytes != sizeof(RECORDTYPE) || header.ColumnCount != columnCount_) return false;
+
+            auto expectedEntries = ColumnEntries();
+            vector<RecordColumnEntry> columnEntries(columnCount_);
+            if (!file.read(reinterpret_cast<char*>(columnEntries.data()), columnCount_ * sizeof(RecordColumnEntry))) return false;
+            if (std::memcmp(columnEntries.data(), expectedEntries.data(), columnCount_ * sizeof(RecordColumnEntry)) != 0) return false;
+
+            string block {};
+            vector<tuple<unsigned long long int, RECORDTYPE>> records {};
+            RecordBlockHeader blockHeader {};
+            while (true)
+            {
+                file.read(reinterpret_cast<char*>(&blockHeader), sizeof(blockHeader));
+                if (file.gcount() == 0 && file.eof()) return true;
+                if (!file || blockHeader.Magic != RecordBlockMagic) return false;
+
+                block.resize(blockHeader.TickBytes + blockHeader.IndexBytes + blockHeader.ColumnBytes);
+                if (!file.read(block.data(), block.size())) return false;
+                if (!DecodeBlock(blockHeader, block, records)) return false;
+
+                for (auto& [tick, record] : records)
+                    forEachRecord(tick, record);
+            }
+        }
+
+        //
+        // Write a binary record file out in the CSV layout of the record type.
+        //
+        static bool ConvertToCsv(const string& binaryPath, const string& csvPath)
+        {
+            ofstream csv(csvPath);
+            if (!csv) return false;
+
+            csv << "Tick," << RECORDTYPE::Header() << '\n';
+            auto read = ReadFile(binaryPath, [&csv](unsigned long long int tick, RECORDTYPE& record)
+                {
+                    csv << tick << ',' << record.Format() << '\n';
+                });
+
+            return read && csv.good();
+        }
+
+    private:
+        static bool DecodeBlock(const RecordBlockHeader& header, const string& block, vector<tuple<unsigned long long int, RECORDTYPE>>& records)
+        {
+            if (header.ColumnBytes != static_cast<unsigned long long int>(header.RecordCount) * FixedRowBytes()) return false;
+
+            records.assign(header.RecordCount, std::make_tuple(0ULL, BlankRecord()));
+
+            const auto* position = block.data();
+            const auto* tickEnd = position + header.TickBytes;
+            unsigned long long int tick { 0ULL };
+            for (auto& record : records)
+            {
+                unsigned long long int delta { 0ULL };
+                if (!ReadVarint(position, tickEnd, delta)) return false;
+                tick += static_cast<unsigned long long int>(UnZigZag(delta));
+                std::get<0>(record) = tick;
+            }
+
+            const auto* indexEnd = tickEnd + header.IndexBytes;
+            unsigned long long int index { 0ULL };
+            for (auto& record : records)
+            {
+                unsigned long long int delta { 0ULL };
+                if (!ReadVarint(position, indexEnd, delta)) return false;
+                index += static_cast<unsigned long long int>(UnZigZag(delta));
+                auto& member = std::get<1>(record).*std::get<0>(columns_);
+                member = static_cast<std::decay_t<decltype(member)>>(index);
+            }
+
+            DecodeFixedColumns(indexEnd, records, std::make_index_sequence<columnCount_>{});
+            return true;
+        }
+
+        //
+        // The columns after the index, each stored as one packed array.
+        //
+        template<size_t... COLUMN>
+        static void EncodeFixedColumns(const vector<tuple<unsigned long long int, RECORDTYPE>>& records, char* column, std::index_sequence<COLUMN...>)
+        {
+            ((column = EncodeFixedColumn<COLUMN>(records, column)), ...);
+        }
+
+        template<size_t COLUMN>
+        static char* EncodeFixedColumn(const vector<tuple<unsigned long long int, RECORDTYPE>>& records, char* column)
+        {
+            if constexpr (COLUMN > 0)
+            {
+                constexpr auto width = ColumnWidth<COLUMN>();
+                for (auto& [tick, record] : records)
+                {
+                    std::memcpy(column, &(record.*std::get<COLUMN>(columns_)), width);
+                    column += width;
+                }
+            }
+
+            return column;
+        }
+
+        template<size_t... COLUMN>
+        static void DecodeFixedColumns(const char* column, vector<tuple<unsigned long long int, RECORDTYPE>>& records, std::index_sequence<COLUMN...>)
+        {
+            ((column = DecodeFixedColumn<COLUMN>(column, records)), ...);
+        }
+
+        template<size_t COLUMN>
+        static const char* DecodeFixedColumn(const char* column, vector<tuple<unsigned long long int, RECORDTYPE>>& records)
+        {
+            if constexpr (COLUMN > 0)
+            {
+                constexpr auto width = ColumnWidth<COLUMN>();
+                for (auto& [tick, record] : records)
+                {
+                    std::memcpy(&(record.*std::get<COLUMN>(columns_)), column, width);
+                    column += width;
+                }
+            }
+
+            return column;
+        }
+
+        template<size_t COLUMN>
+        static constexpr size_t ColumnWidth()
+        {
+            return sizeof(std::declval<RECORDTYPE&>().*std::get<COLUMN>(columns_));
+        }
+
+        template<size_t... COLUMN>
+        static constexpr size_t FixedRowBytes(std::index_sequence<COLUMN...>)
+        {
+            return ((COLUMN > 0 ? ColumnWidth<COLUMN>() : 0) + ... + 0);
+        }
+
+        static constexpr size_t FixedRowBytes()
+        {
+            return FixedRowBytes(std::make_index_sequence<columnCount_>{});
+        }
+
+        //
+        // The column layout, so a file is only read back by a matching record type.
+        //
+        static vector<RecordColumnEntry> ColumnEntries()
+        {
+            vector<RecordColumnEntry> columnEntries {};
+            auto record = BlankRecord();
+            auto* base = reinterpret_cast<const char*>(&record);
+            std::apply([&columnEntries, &record, base](auto... member)
+                {
+                    ((columnEntries.push_back(RecordColumnEntry {
+                        static_cast<unsigned int>(reinterpret_cast<const char*>(&(record.*member)) - base),
+                        static_cast<unsigned int>(sizeof(record.*member)) })), ...);
+                }, columns_);
+
+            return columnEntries;
+        }
+
+        //
+        // Record types need not be default constructible, so records are
+        // read back into zeroed storage.
+        //
+        static RECORDTYPE BlankRecord()
+        {
+            alignas(RECORDTYPE) unsigned char storage[sizeof(RECORDTYPE)] { };
+            return *std::launder(reinterpret_cast<RECORDTYPE*>(storage));
+        }
+
+        static void Append(string& out, const void* data, size_t bytes)
+        {
+            out.append(static_cast<const char*>(data), bytes);
+        }
+
+        static unsigned long long int ZigZag(long long int value)
+        {
+            return (static_cast<unsigned long long int>(value) << 1) ^ static_cast<unsigned long long int>(value >> 63);
+        }
+
+        static long long int UnZigZag(unsigned long long int value)
+        {
+            return static_cast<long long int>(value >> 1) ^ -static_cast<long long int>(value & 1);
+        }
+
+        static void AppendVarint(string& out, unsigned long long int value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        static bool ReadVarint(const char*& position, const char* end, unsigned long long int& value)
+        {
+            value = 0ULL;
+            for (auto shift = 0; position < end && shift < 64; shift += 7)
+            {
+                auto byte = static_cast<unsigned char>(*position++);
+                value |= static_cast<unsigned long long int>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) return true;
+            }
+
+            return false;
+        }
+    };
+}
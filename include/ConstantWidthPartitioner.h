@@ -1,6 +1,9 @@
 #pragma once
 
+#include <vector>
+
 #include "IModelEnginePartitioner.h"
+#include "IModelEngineBacklog.h"
 #include "ModelEngineCommon.h"
 #include "ModelEngineContext.h"
 #include "Worker.h"
@@ -8,6 +11,7 @@
 
 namespace embeddedpenguins::modelengine
 {
+    using std::vector;
     using embeddedpenguins::modelengine::threads::Worker;
     using embeddedpenguins::modelengine::threads::WorkerContextOp;
 
@@ -17,15 +21,16 @@ namespace embeddedpenguins::modelengine
     // or more workers going idle during many scans.
     //
     template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
-    class ConstantWidthPartitioner : public IModelEnginePartitioner
+    class ConstantWidthPartitioner : public IModelEnginePartitioner, public IModelEngineBacklog<OPERATORTYPE>
     {
         ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context_;
+        vector<vector<WorkItem<OPERATORTYPE>>> workForWorkers_ {};
 
     public:
         ConstantWidthPartitioner(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context) :
             context_(context)
         {
-
+            context_.Backlog = this;
         }
 
         virtual void ConcurrentPartitionStep() override
@@ -44,6 +49,47 @@ namespace embeddedpenguins::modelengine
             return totalWork;
         }
 
+        // All future work is distributed to the workers as soon as it is created.
+        virtual unsigned long long int BacklogSize() override
+        {
+            return 0ULL;
+        }
+
+        // Work is distributed without regard to its tick, so no tick can be skipped.
+        virtual unsigned long long int NextScheduledTick() override
+        {
+            return context_.Iterations;
+        }
+
+        // No work is held back for later ticks.
+        virtual void ExportBacklog(vector<WorkItem<OPERATORTYPE>>& /*backlog*/) override
+        {
+        }
+
+        // Work is distributed without regard to its tick, so restored future work is distributed too.
+        virtual void ImportPendingWork(const vector<WorkItem<OPERATORTYPE>>& workForTick, const vector<WorkItem<OPERATORTYPE>>& backlog) override
+        {
+            workForWorkers_.resize(context_.Workers.size());
+            for (auto& workForThread : workForWorkers_)
+                workForThread.clear();
+
+            for (auto* restoredWork : { &workForTick, &backlog })
+            {
+                for (auto work : *restoredWork)
+                {
+                    for (auto target = 0ULL; target < context_.Workers.size(); target++)
+                    {
+                        WorkerContextOp<OPERATORTYPE, RECORDTYPE> targetContextOp(context_.Workers[target]->GetContext());
+                        if (targetContextOp.PushIfInRange(work, workForWorkers_[target]))
+                            break;
+                    }
+                }
+            }
+
+            for (auto target = 0ULL; target < context_.Workers.size(); target++)
+                context_.Workers[target]->GetContext().WorkForThread.Assign(workForWorkers_[target]);
+        }
+
     protected:
         unsigned long int AccumulateWorkfromWorkers()
         {
@@ -56,6 +102,10 @@ namespace embeddedpenguins::modelengine
                 targetslice->GetContext().WorkForThread.clear();
             }
 
+            workForWorkers_.resize(context_.Workers.size());
+            for (auto& workForThread : workForWorkers_)
+                workForThread.clear();
+
             return totalWork;
         }
 
@@ -69,16 +119,20 @@ namespace embeddedpenguins::modelengine
                 for (auto& sourcework : workForFutureTicks)
                 //for (auto& sourcework : sourceWorker->GetContext().WorkForNextThread)
                 {
-                    for (auto& targetslice : context_.Workers)
+                    for (auto target = 0ULL; target < context_.Workers.size(); target++)
                     {
-                        WorkerContextOp<OPERATORTYPE, RECORDTYPE> targetContextOp(targetslice->GetContext());
-                        if (targetContextOp.PushIfInRange(sourcework))
+                        WorkerContextOp<OPERATORTYPE, RECORDTYPE> targetContextOp(context_.Workers[target]->GetContext());
+                        if (targetContextOp.PushIfInRange(sourcework, workForWorkers_[target]))
                             break;
                     }
                 }
 
                 workForFutureTicks.clear();
             }
+
+            // Each worker processes its buffer in place.
+            for (auto target = 0ULL; target < context_.Workers.size(); target++)
+                context_.Workers[target]->GetContext().WorkForThread.Assign(workForWorkers_[target]);
         }
     };
 }
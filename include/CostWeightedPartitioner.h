@@ -0,0 +1,250 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+
+#include "AdaptiveWidthPartitioner.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+
+    constexpr unsigned int CostClassLimit { 16 };
+    constexpr double CostLearningRate { 0.25 };
+
+    //
+    // An operation type opts in to separate cost estimates for different kinds
+    // of operation with a CostClass() member returning a small number, such as
+    // its operation code:
+    //     unsigned int CostClass() const { return static_cast<unsigned int>(Op); }
+    // Classes at or above CostClassLimit share the last class.  Operations
+    // without a CostClass() all fall in class zero.
+    //
+    template<class OPERATORTYPE, class = void>
+    struct HasCostClass : std::false_type { };
+
+    template<class OPERATORTYPE>
+    struct HasCostClass<OPERATORTYPE, std::void_t<decltype(std::declval<const OPERATORTYPE&>().CostClass())>> : std::true_type { };
+
+    //
+    // CostWeightedPartitioner.  Like the adaptive partitioner, but cut the work
+    // for each tick into segments of about equal estimated cost, rather than
+    // equal numbers of work items, so the slowest worker finishes sooner.
+    // A work item is estimated to cost the sum of an estimate for its cost
+    // class and one for the region of the model its index falls in.
+    // The estimates are learned from each worker's Process() time in the tick
+    // just run: the error between the time a segment took and the time its
+    // items were estimated to take is spread over the estimates of its classes,
+    // and separately over those of its regions, in proportion to how many of
+    // its items each one covers (a normalized least-mean-squares step).
+    // Until anything has been learned, segments are cut by item count.
+    // With work stealing, workers process each other's segments, so their
+    // times say nothing of their own, and the estimates are left as they are.
+    //
+    template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
+    class CostWeightedPartitioner : public AdaptiveWidthPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>
+    {
+        using AdaptiveWidth = AdaptiveWidthPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>;
+
+        // Expose some internal state to derived classes to allow for testing.
+    protected:
+        using AdaptiveWidth::context_;
+
+        unsigned int regionCount_ { 1 };
+        unsigned long long int regionWidth_ { 1ULL };
+        // The class estimates, followed by the region estimates, in nanoseconds.
+        vector<double> costs_ {};
+        // For each worker, how many items of its segment fall in each class, then in each region.
+        vector<vector<double>> segmentCounts_ {};
+
+    public:
+        CostWeightedPartitioner(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context) :
+            AdaptiveWidth(context)
+        {
+        }
+
+        //
+        // Learn from the tick just run before cutting the work for the next one.
+        //
+        virtual unsigned long int SingleThreadPartitionStep() override
+        {
+            LearnFromLastTick();
+            return AdaptiveWidth::SingleThreadPartitionStep();
+        }
+
+        //
+        // Dense ticks are cut by index alone, which would leave nothing to learn from.
+        //
+        virtual bool DenseFrontierAllowed() const override
+        {
+            return false;
+        }
+
+        const double ClassCost(unsigned int costClass) const { return costs_.empty() ? 0.0 : costs_[std::min(costClass, CostClassLimit - 1)]; }
+        const double RegionCost(unsigned int region) const { return costs_.empty() ? 0.0 : costs_[CostClassLimit + std::min(region, regionCount_ - 1)]; }
+
+    protected:
+        virtual void FindSegmentEnds(vector<WorkItem<OPERATORTYPE>>& workForTimeSlice, vector<unsigned long long int>& segmentEnds) override
+        {
+            SizeEstimates();
+
+            auto totalCost { 0.0 };
+            for (auto& work : workForTimeSlice)
+                totalCost += Cost(work);
+
+            if (totalCost <= 0.0)
+                AdaptiveWidth::FindSegmentEnds(workForTimeSlice, segmentEnds);
+            else
+                FindCostSegmentEnds(workForTimeSlice, segmentEnds, totalCost);
+
+            CountSegments(workForTimeSlice, segmentEnds);
+        }
+
+        //
+        // Each segment takes about an equal share of the cost not yet assigned.
+        // Work is cut only between indexes, and a group of items for one index
+        // goes to the segment it would bring closer to its share.  While there
+        // are indexes enough, every worker is left at least one.
+        //
+        void FindCostSegmentEnds(vector<WorkItem<OPERATORTYPE>>& workForTimeSlice, vector<unsigned long long int>& segmentEnds, double totalCost)
+        {
+            auto workerCount = context_.Workers.size();
+            auto workSize = workForTimeSlice.size();
+            auto remainingCost = totalCost;
+            auto position { 0ULL };
+
+            auto groupsLeft { 0ULL };
+            for (auto item = 0ULL; item < workSize; item++)
+                if (item == 0 || workForTimeSlice[item].Operator.Index != workForTimeSlice[item - 1].Operator.Index)
+                    groupsLeft++;
+
+            segmentEnds.clear();
+            for (auto workerIndex = 0ULL; workerIndex < workerCount; workerIndex++)
+            {
+                if (workerIndex == workerCount - 1)
+                {
+                    segmentEnds.push_back(workSize);
+                    break;
+                }
+
+                auto workersAfter = workerCount - workerIndex - 1;
+                auto targetCost = remainingCost / (workerCount - workerIndex);
+                auto segmentCost { 0.0 };
+                while (position < workSize && groupsLeft > workersAfter)
+                {
+                    auto groupEnd = position;
+                    auto groupCost { 0.0 };
+                    do groupCost += Cost(workForTimeSlice[groupEnd++]);
+                    while (groupEnd < workSize && workForTimeSlice[groupEnd].Operator.Index == workForTimeSlice[position].Operator.Index);
+
+                    if (segmentCost > 0.0 && segmentCost + groupCost / 2.0 > targetCost) break;
+                    segmentCost += groupCost;
+                    position = groupEnd;
+                    groupsLeft--;
+                }
+
+                remainingCost -= segmentCost;
+                segmentEnds.push_back(position);
+            }
+        }
+
+        //
+        // Correct the estimates from the time each worker spent processing
+        // the segment it was given.
+        // NOTE: This MUST NOT run concurrently with the worker threads.
+        //
+        void LearnFromLastTick()
+        {
+            if (context_.WorkStealing || segmentCounts_.size() != context_.Workers.size()) return;
+
+            for (auto workerIndex = 0ULL; workerIndex < segmentCounts_.size(); workerIndex++)
+            {
+                auto& counts = segmentCounts_[workerIndex];
+                auto& tally = context_.Workers[workerIndex]->GetContext().Tally;
+                if (tally.ProcessEndTime <= tally.WakeTime) continue;
+
+                auto estimated { 0.0 };
+                for (auto feature = 0ULL; feature < counts.size(); feature++)
+                    estimated += counts[feature] * costs_[feature];
+
+                // Classes and regions each take half the error, so the many
+                // regions are not drowned out by the few classes.
+                auto measured = static_cast<double>(duration_cast<nanoseconds>(tally.ProcessEndTime - tally.WakeTime).count());
+                auto error = (measured - estimated) / 2.0;
+                Learn(counts, error, 0, CostClassLimit);
+                Learn(counts, error, CostClassLimit, counts.size());
+            }
+
+            for (auto& counts : segmentCounts_)
+                std::fill(begin(counts), end(counts), 0.0);
+        }
+
+        void Learn(const vector<double>& counts, double error, unsigned long long int firstFeature, unsigned long long int lastFeature)
+        {
+            auto norm { 0.0 };
+            for (auto feature = firstFeature; feature < lastFeature; feature++)
+                norm += counts[feature] * counts[feature];
+            if (norm <= 0.0) return;
+
+            auto step = CostLearningRate * error / norm;
+            for (auto feature = firstFeature; feature < lastFeature; feature++)
+                if (counts[feature] > 0.0)
+                    costs_[feature] = std::max(0.0, costs_[feature] + step * counts[feature]);
+        }
+
+        double Cost(const WorkItem<OPERATORTYPE>& work) const
+        {
+            return costs_[CostClassOf(work.Operator)] + costs_[CostClassLimit + RegionOf(work.Operator.Index)];
+        }
+
+        static unsigned int CostClassOf(const OPERATORTYPE& operation)
+        {
+            if constexpr (HasCostClass<OPERATORTYPE>::value)
+                return std::min(static_cast<unsigned int>(operation.CostClass()), CostClassLimit - 1);
+            else
+                return 0;
+        }
+
+        unsigned int RegionOf(unsigned long long int index) const
+        {
+            return std::min(static_cast<unsigned int>(index / regionWidth_), regionCount_ - 1);
+        }
+
+    private:
+        void SizeEstimates()
+        {
+            if (costs_.empty())
+            {
+                regionCount_ = std::max(1U, context_.CostRegions);
+                auto modelSize = std::max(1ULL, static_cast<unsigned long long int>(context_.Helper.Model().ModelSize()));
+                regionWidth_ = std::max(1ULL, (modelSize + regionCount_ - 1) / regionCount_);
+                costs_.assign(CostClassLimit + regionCount_, 0.0);
+            }
+
+            if (segmentCounts_.size() != context_.Workers.size())
+                segmentCounts_.assign(context_.Workers.size(), vector<double>(costs_.size(), 0.0));
+        }
+
+        void CountSegments(const vector<WorkItem<OPERATORTYPE>>& workForTimeSlice, const vector<unsigned long long int>& segmentEnds)
+        {
+            auto segmentBegin { 0ULL };
+            for (auto workerIndex = 0ULL; workerIndex < segmentEnds.size() && workerIndex < segmentCounts_.size(); workerIndex++)
+            {
+                auto& counts = segmentCounts_[workerIndex];
+                std::fill(begin(counts), end(counts), 0.0);
+                for (auto position = segmentBegin; position < segmentEnds[workerIndex]; position++)
+                {
+                    auto& operation = workForTimeSlice[position].Operator;
+                    counts[CostClassOf(operation)] += 1.0;
+                    counts[CostClassLimit + RegionOf(operation.Index)] += 1.0;
+                }
+                segmentBegin = segmentEnds[workerIndex];
+            }
+        }
+    };
+}
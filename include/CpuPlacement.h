@@ -0,0 +1,157 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+
+#include <sched.h>
+#include <pthread.h>
+
+namespace embeddedpenguins::modelengine::threads
+{
+    using std::string;
+    using std::vector;
+    using std::ifstream;
+    using std::istringstream;
+
+    //
+    // Choose the CPUs the engine and worker threads run on, and pin threads to them.
+    // The usable CPUs are the ones in this process's affinity mask, so that a
+    // container's cpuset is respected, optionally narrowed to a configured list,
+    // and optionally with all but the first hardware thread of each core removed.
+    // The engine thread runs on the first usable CPU, and worker N on the Nth
+    // after it, wrapping around if there are more threads than CPUs.
+    //
+    class CpuPlacement
+    {
+    public:
+        //
+        // Find the CPUs this process may run on.  If the affinity mask
+        // cannot be read, assume all hardware threads are available.
+        //
+        static vector<int> AllowedCpus()
+        {
+            vector<int> cpus {};
+
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0)
+            {
+                for (auto cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                    if (CPU_ISSET(cpu, &cpuSet)) cpus.push_back(cpu);
+            }
+
+            if (cpus.empty())
+            {
+                auto cpuCount = static_cast<int>(std::thread::hardware_concurrency());
+                for (auto cpu = 0; cpu < cpuCount; cpu++)
+                    cpus.push_back(cpu);
+            }
+
+            return cpus;
+        }
+
+        //
+        // The allowed CPUs, restricted to the configured cores if any are
+        // configured, in the configured order.  With SMT siblings skipped,
+        // only the lowest-numbered usable hardware thread of each core remains.
+        //
+        static vector<int> UsableCpus(const vector<int>& configuredCores, bool skipSmtSiblings)
+        {
+            auto allowedCpus = AllowedCpus();
+
+            vector<int> cpus {};
+            if (configuredCores.empty())
+            {
+                cpus = allowedCpus;
+            }
+            else
+            {
+                for (auto cpu : configuredCores)
+                    if (std::find(begin(allowedCpus), end(allowedCpus), cpu) != end(allowedCpus) && std::find(begin(cpus), end(cpus), cpu) == end(cpus))
+                        cpus.push_back(cpu);
+            }
+
+            if (skipSmtSiblings)
+            {
+                vector<int> firstSiblings {};
+                for (auto cpu : cpus)
+                {
+                    auto siblings = SmtSiblings(cpu);
+                    auto isFirst = std::none_of(begin(siblings), end(siblings), [&cpus, cpu](int sibling)
+                        {
+                            return sibling < cpu && std::find(begin(cpus), end(cpus), sibling) != end(cpus);
+                        });
+                    if (isFirst) firstSiblings.push_back(cpu);
+                }
+                cpus = firstSiblings;
+            }
+
+            return cpus;
+        }
+
+        //
+        // The CPU for a thread, where thread 0 is the engine thread
+        // and threads 1 through N are the workers.
+        //
+        static int CpuForThread(const vector<int>& cpus, int thread)
+        {
+            if (cpus.empty()) return -1;
+            return cpus[thread % cpus.size()];
+        }
+
+        //
+        // Pin the calling thread to one CPU.  Return false if it could not be pinned.
+        //
+        static bool PinCurrentThread(int cpu)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            CPU_SET(cpu, &cpuSet);
+            return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+        }
+
+        //
+        // Parse a kernel CPU list such as "0-3,8,10-11".
+        //
+        static vector<int> ParseCpuList(const string& cpuList)
+        {
+            vector<int> cpus {};
+
+            istringstream listStream(cpuList);
+            string range {};
+            while (std::getline(listStream, range, ','))
+            {
+                if (range.empty() || !isdigit(range[0])) continue;
+
+                auto dash = range.find('-');
+                auto first = std::stoi(range.substr(0, dash));
+                auto last = (dash == string::npos) ? first : std::stoi(range.substr(dash + 1));
+                for (auto cpu = first; cpu <= last; cpu++)
+                    cpus.push_back(cpu);
+            }
+
+            return cpus;
+        }
+
+    private:
+        //
+        // The hardware threads sharing a core with this CPU, including itself.
+        //
+        static vector<int> SmtSiblings(int cpu)
+        {
+            ifstream siblingsFile("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/thread_siblings_list");
+            string siblingList {};
+            if (siblingsFile && std::getline(siblingsFile, siblingList))
+                return ParseCpuList(siblingList);
+
+            return vector<int> { cpu };
+        }
+    };
+}
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+#include "WorkItem.h"
+#include "WorkItemSorter.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+
+    constexpr double DefaultDenseFrontierFraction { 0.05 };
+    constexpr unsigned long long int DenseFrontierBatch { 4096ULL };
+
+    //
+    // The work for one tick held densely, for ticks when a large fraction of
+    // the model is active, in the manner of Ligra's dense frontier: one bit
+    // for each model node marking it active, and one slot for each node
+    // holding its work item.  Scattering work into it costs one write for
+    // each item, and reading it back is a sweep of the bitmap in index order,
+    // so no sorting or merging is needed to group the work by index.
+    // A second item for an index is combined into the slot if the operation
+    // type has a Combine() member that accepts it; otherwise it goes to a
+    // small overflow list, kept sorted by index, and is read back just after
+    // the slot for its index, so items for an index keep their order.
+    // Workers each read back and clear a stripe; stripes start on whole
+    // words of the bitmap, so no two workers share a word.
+    //
+    template<class OPERATORTYPE>
+    class DenseFrontier
+    {
+        vector<unsigned long long int> words_ {};
+        vector<WorkItem<OPERATORTYPE>> slots_ {};
+        vector<WorkItem<OPERATORTYPE>> overflow_ {};
+        unsigned long long int count_ { 0ULL };
+
+    public:
+        const unsigned long long int Capacity() const { return slots_.size(); }
+        const unsigned long long int Count() const { return count_; }
+        const unsigned long long int WordCount() const { return words_.size(); }
+
+        //
+        // Size for a model.  Only call this while the frontier is empty.
+        //
+        void Resize(unsigned long long int nodeCount)
+        {
+            if (nodeCount == slots_.size()) return;
+
+            words_.assign((nodeCount + 63) / 64, 0ULL);
+            slots_.resize(nodeCount);
+        }
+
+        //
+        // Add an item to the frontier, combining it into the item already
+        // held for its index if allowed.  Items for indexes outside the model
+        // are kept in the overflow list.
+        //
+        void Insert(const WorkItem<OPERATORTYPE>& work, bool combine)
+        {
+            auto index = static_cast<unsigned long long int>(work.Operator.Index);
+            if (index >= slots_.size())
+            {
+                overflow_.push_back(work);
+                count_++;
+                return;
+            }
+
+            auto& word = words_[index / 64];
+            auto bit = 1ULL << (index % 64);
+            if ((word & bit) == 0)
+            {
+                word |= bit;
+                slots_[index] = work;
+                count_++;
+                return;
+            }
+
+            if constexpr (HasCombine<OPERATORTYPE>::value)
+                if (combine && slots_[index].Operator.Combine(work.Operator))
+                    return;
+
+            overflow_.push_back(work);
+            count_++;
+        }
+
+        //
+        // Call once all items are inserted, before any are read back.
+        //
+        void FinishInserting(WorkItemSorter<OPERATORTYPE>& sorter)
+        {
+            sorter.SortByIndex(overflow_, slots_.size());
+        }
+
+        //
+        // Forget any overflow left from the last tick, before inserting anew.
+        // The bitmap is cleared by the workers as they read it back.
+        //
+        void StartInserting()
+        {
+            overflow_.clear();
+            count_ = 0ULL;
+        }
+
+        //
+        // The number of active indexes held in a word of the bitmap.
+        //
+        unsigned int ActiveInWord(unsigned long long int word) const
+        {
+            return static_cast<unsigned int>(__builtin_popcountll(words_[word]));
+        }
+
+        //
+        // Read back the items of the nodes from firstWord*64 up to lastWord*64
+        // (or the end of the model) in index order, and pass them in batches
+        // to the handler as a pair of iterators.  Overflow for indexes past the
+        // model is read back by the stripe ending at the last word.  If clear
+        // is set, the bitmap of the stripe is cleared as it is read.
+        //
+        template<class HANDLER>
+        void ReadStripe(unsigned long long int firstWord, unsigned long long int lastWord, bool clear, vector<WorkItem<OPERATORTYPE>>& batch, HANDLER&& handler)
+        {
+            batch.clear();
+            auto overflow = std::lower_bound(begin(overflow_), end(overflow_), firstWord * 64,
+                [](const WorkItem<OPERATORTYPE>& work, unsigned long long int index) { return static_cast<unsigned long long int>(work.Operator.Index) < index; });
+
+            for (auto word = firstWord; word < lastWord && word < words_.size(); word++)
+            {
+                auto bits = words_[word];
+                while (bits != 0)
+                {
+                    auto index = word * 64 + static_cast<unsigned long long int>(__builtin_ctzll(bits));
+                    bits &= bits - 1;
+
+                    batch.push_back(slots_[index]);
+                    while (overflow != end(overflow_) && static_cast<unsigned long long int>(overflow->Operator.Index) == index)
+                        batch.push_back(*overflow++);
+
+                    if (batch.size() >= DenseFrontierBatch)
+                    {
+                        handler(begin(batch), end(batch));
+                        batch.clear();
+                    }
+                }
+
+                if (clear) words_[word] = 0ULL;
+            }
+
+            if (lastWord >= words_.size())
+                while (overflow != end(overflow_))
+                    batch.push_back(*overflow++);
+
+            if (!batch.empty())
+                handler(begin(batch), end(batch));
+            batch.clear();
+        }
+
+        //
+        // Append a copy of every item held, in index order, leaving the frontier intact.
+        //
+        void CopyTo(vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            vector<WorkItem<OPERATORTYPE>> batch;
+            ReadStripe(0ULL, words_.size(), false, batch,
+                [&work](auto batchBegin, auto batchEnd) { work.insert(end(work), batchBegin, batchEnd); });
+        }
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace embeddedpenguins::modelengine::threads
+{
+    using std::atomic;
+    using std::unique_ptr;
+    using std::vector;
+    using std::size_t;
+
+    constexpr size_t DefaultDirtyBlockBytes { 4096 };
+
+    //
+    // One bit for each fixed-size block of model nodes, set when any node
+    // in the block may have changed since the bits were last taken.
+    // Workers mark the index of every operation they process, which covers
+    // the usual case of an operation changing only the node at its own index.
+    // Stripes may share a word at their edges, so marking is atomic, but a
+    // bit that is already set is only read, so a busy block costs no writes.
+    //
+    class DirtyBlockMap
+    {
+        unique_ptr<atomic<unsigned long long int>[]> words_ {};
+        unsigned long long int wordCount_ { 0ULL };
+        unsigned long long int nodeCount_ { 0ULL };
+        unsigned long long int blockNodes_ { 1ULL };
+
+    public:
+        const unsigned long long int NodeCount() const { return nodeCount_; }
+        const unsigned long long int BlockNodes() const { return blockNodes_; }
+        const unsigned long long int BlockCount() const { return (nodeCount_ + blockNodes_ - 1) / blockNodes_; }
+
+        //
+        // Size the map for a model, with blocks of about the given number of bytes.
+        // Only call this while no worker thread is running.
+        //
+        void Resize(unsigned long long int nodeCount, size_t nodeBytes, size_t blockBytes = DefaultDirtyBlockBytes)
+        {
+            nodeCount_ = nodeCount;
+            blockNodes_ = (nodeBytes >= blockBytes) ? 1ULL : blockBytes / nodeBytes;
+            wordCount_ = (BlockCount() + 63) / 64;
+            words_ = unique_ptr<atomic<unsigned long long int>[]>(new atomic<unsigned long long int>[wordCount_]);
+            for (auto word = 0ULL; word < wordCount_; word++)
+                words_[word].store(0ULL, std::memory_order_relaxed);
+        }
+
+        void Mark(unsigned long long int index)
+        {
+            if (index >= nodeCount_) return;
+
+            auto block = index / blockNodes_;
+            auto& word = words_[block / 64];
+            auto bit = 1ULL << (block % 64);
+            if ((word.load(std::memory_order_relaxed) & bit) == 0)
+                word.fetch_or(bit, std::memory_order_relaxed);
+        }
+
+        //
+        // Collect the dirty blocks in ascending order and clear them.
+        // Only call this while no worker thread is running.
+        //
+        void TakeDirtyBlocks(vector<unsigned long long int>& blocks)
+        {
+            for (auto word = 0ULL; word < wordCount_; word++)
+            {
+                auto bits = words_[word].exchange(0ULL, std::memory_order_relaxed);
+                while (bits != 0)
+                {
+                    auto bit = static_cast<unsigned long long int>(__builtin_ctzll(bits));
+                    blocks.push_back(word * 64 + bit);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <type_traits>
+
+namespace embeddedpenguins::modelengine
+{
+    using std::atomic;
+    using std::unique_ptr;
+    using std::vector;
+
+    //
+    // What one worker did in the last tick.  Wait is the time the worker
+    // sat finished at the done barrier while the slowest worker caught up;
+    // wake latency is the time from the engine signalling the tick to the
+    // worker starting on it.
+    //
+    struct WorkerTelemetry
+    {
+        unsigned long long int ItemsProcessed { 0ULL };
+        unsigned long long int ItemsEmitted { 0ULL };
+        unsigned long long int ProcessNanoseconds { 0ULL };
+        unsigned long long int WaitNanoseconds { 0ULL };
+        unsigned long long int WakeNanoseconds { 0ULL };
+    };
+
+    //
+    // What the engine did in the last tick.  Load imbalance is the slowest
+    // worker's process time over the mean process time of all workers,
+    // so 1.0 is perfectly balanced.
+    //
+    struct TickTelemetry
+    {
+        unsigned long long int Tick { 0ULL };
+        unsigned long long int TotalWork { 0ULL };
+        unsigned long long int ItemsProcessed { 0ULL };
+        unsigned long long int ItemsEmitted { 0ULL };
+        unsigned long long int TickNanoseconds { 0ULL };
+        unsigned long long int PartitionNanoseconds { 0ULL };
+        double LoadImbalance { 1.0 };
+    };
+
+    struct EngineTelemetry
+    {
+        TickTelemetry Engine {};
+        vector<WorkerTelemetry> Workers {};
+    };
+
+    //
+    // Publish the telemetry of each tick from the engine thread, for any
+    // number of other threads to read without locks and without slowing
+    // the engine.  A sequence lock: the publisher makes the sequence odd,
+    // stores the telemetry, and makes it even again; a reader copies the
+    // telemetry out and keeps it only if the sequence was even and unchanged
+    // throughout.  The telemetry is stored in relaxed atomic words, so torn
+    // copies are discarded rather than being data races.
+    // Size the channel before the engine starts and before anyone reads it.
+    //
+    class TelemetryChannel
+    {
+        static_assert(std::is_trivially_copyable_v<TickTelemetry> && sizeof(TickTelemetry) % sizeof(unsigned long long int) == 0);
+        static_assert(std::is_trivially_copyable_v<WorkerTelemetry> && sizeof(WorkerTelemetry) % sizeof(unsigned long long int) == 0);
+
+        static constexpr std::size_t TickWords { sizeof(TickTelemetry) / sizeof(unsigned long long int) };
+        static constexpr std::size_t WorkerWords { sizeof(WorkerTelemetry) / sizeof(unsigned long long int) };
+
+        alignas(64) atomic<unsigned long long int> sequence_ { 0ULL };
+        unique_ptr<atomic<unsigned long long int>[]> words_ {};
+        std::size_t workerCount_ { 0 };
+        vector<unsigned long long int> staging_ {};
+
+    public:
+        const std::size_t WorkerCount() const { return workerCount_; }
+
+        void Resize(std::size_t workerCount)
+        {
+            workerCount_ = workerCount;
+            auto wordCount = TickWords + workerCount_ * WorkerWords;
+            words_ = unique_ptr<atomic<unsigned long long int>[]>(new atomic<unsigned long long int>[wordCount]);
+            for (auto word = 0ULL; word < wordCount; word++)
+                words_[word].store(0ULL, std::memory_order_relaxed);
+            staging_.resize(wordCount);
+            sequence_.store(0ULL, std::memory_order_release);
+        }
+
+        //
+        // Only one thread may publish.  Workers beyond the size of the channel are ignored.
+        //
+        void Publish(const TickTelemetry& engine, const WorkerTelemetry* workers, std::size_t workerCount)
+        {
+            if (!words_) return;
+
+            std::memcpy(staging_.data(), &engine, sizeof(TickTelemetry));
+            for (auto worker = 0ULL; worker < workerCount_ && worker < workerCount; worker++)
+                std::memcpy(staging_.data() + TickWords + worker * WorkerWords, &workers[worker], sizeof(WorkerTelemetry));
+
+            auto sequence = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (auto word = 0ULL; word < staging_.size(); word++)
+                words_[word].store(staging_[word], std::memory_order_relaxed);
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        //
+        // Copy out the last telemetry published.  Retry while a publish is under way.
+        //
+        void Read(EngineTelemetry& telemetry) const
+        {
+            telemetry.Workers.resize(workerCount_);
+            if (!words_) return;
+
+            vector<unsigned long long int> copy(TickWords + workerCount_ * WorkerWords);
+            while (true)
+            {
+                auto before = sequence_.load(std::memory_order_acquire);
+                if ((before & 1ULL) == 0)
+                {
+                    for (auto word = 0ULL; word < copy.size(); word++)
+                        copy[word] = words_[word].load(std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (sequence_.load(std::memory_order_relaxed) == before) break;
+                }
+
+                std::this_thread::yield();
+            }
+
+            std::memcpy(static_cast<void*>(&telemetry.Engine), copy.data(), sizeof(TickTelemetry));
+            for (auto worker = 0ULL; worker < workerCount_; worker++)
+                std::memcpy(static_cast<void*>(&telemetry.Workers[worker]), copy.data() + TickWords + worker * WorkerWords, sizeof(WorkerTelemetry));
+        }
+    };
+}
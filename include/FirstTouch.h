@@ -0,0 +1,93 @@
+#pragma once
+
+#include <new>
+#include <thread>
+#include <vector>
+#include <type_traits>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "CpuPlacement.h"
+#include "HugePageAllocator.h"
+
+namespace embeddedpenguins::modelengine::threads
+{
+    using std::vector;
+    using std::thread;
+    using embeddedpenguins::modelengine::HugePageAllocator;
+    using embeddedpenguins::modelengine::HugePageBytes;
+
+    //
+    // Spread the pages of a freshly allocated model across the NUMA nodes
+    // of the threads that will work on it.  Linux places a page on the node
+    // of the thread that first touches it, so a model allocated and zeroed by
+    // one thread lives entirely on that thread's node.
+    // Here each stripe is handed to a thread pinned to the CPU of the worker
+    // that owns it.  That thread drops the pages lying wholly inside its stripe,
+    // and constructs every node of the stripe again, so the dropped pages come
+    // back on its own node.  The stripes are also initialized in parallel.
+    // Pages that straddle two stripes are left where they are.  A model on
+    // huge pages is released in whole huge pages, so none are split.
+    // Only nodes that can be constructed over without being destroyed are
+    // redistributed; any other model is left as allocated.
+    //
+    class FirstTouch
+    {
+    public:
+        //
+        // The stripe bounds match the ranges CreateWorkers() gives each worker,
+        // and stripeCpus[N] is the CPU of the worker owning stripe N, or -1
+        // if the workers are not pinned.
+        //
+        template<class NODETYPE, class ALLOCATOR>
+        static bool SpreadModel(vector<NODETYPE, ALLOCATOR>& model, const vector<int>& stripeCpus)
+        {
+            if constexpr (std::is_trivially_destructible_v<NODETYPE> && std::is_nothrow_default_constructible_v<NODETYPE>)
+            {
+                auto stripeCount = static_cast<unsigned long int>(stripeCpus.size());
+                if (stripeCount < 2 || model.size() < stripeCount) return false;
+
+                std::uintptr_t pageSize = std::is_same_v<ALLOCATOR, HugePageAllocator<NODETYPE>> ? HugePageBytes : sysconf(_SC_PAGESIZE);
+                auto segmentSize = model.size() / stripeCount;
+                vector<thread> touchThreads {};
+                for (auto stripe = 0UL; stripe < stripeCount; stripe++)
+                {
+                    auto* stripeBegin = model.data() + stripe * segmentSize;
+                    auto* stripeEnd = (stripe == stripeCount - 1) ? model.data() + model.size() : stripeBegin + segmentSize;
+                    auto cpu = stripeCpus[stripe];
+
+                    touchThreads.push_back(thread([stripeBegin, stripeEnd, cpu, pageSize]()
+                        {
+                            if (cpu >= 0) CpuPlacement::PinCurrentThread(cpu);
+                            ReleaseWholePages(stripeBegin, stripeEnd, pageSize);
+                            for (auto* node = stripeBegin; node < stripeEnd; node++)
+                                new (node) NODETYPE();
+                        }));
+                }
+
+                for (auto& touchThread : touchThreads)
+                    touchThread.join();
+
+                return true;
+            }
+
+            return false;
+        }
+
+    private:
+        //
+        // Give back the pages lying wholly inside [begin, end), so the next
+        // touch faults in fresh zeroed pages.
+        //
+        template<class NODETYPE>
+        static void ReleaseWholePages(NODETYPE* begin, NODETYPE* end, std::uintptr_t pageSize)
+        {
+            auto firstPage = (reinterpret_cast<std::uintptr_t>(begin) + pageSize - 1) / pageSize * pageSize;
+            auto lastPage = reinterpret_cast<std::uintptr_t>(end) / pageSize * pageSize;
+            if (firstPage < lastPage)
+                madvise(reinterpret_cast<void*>(firstPage), lastPage - firstPage, MADV_DONTNEED);
+        }
+    };
+}
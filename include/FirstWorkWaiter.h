@@ -1,30 +1,87 @@
 #pragma once
 
+#include <chrono>
+#include <limits>
+
 #include "ModelEngineContextOp.h"
 #include "IModelEngineWaiter.h"
 
 namespace embeddedpenguins::modelengine
 {
+    using std::chrono::high_resolution_clock;
+    using time_point = std::chrono::high_resolution_clock::time_point;
+    using std::chrono::microseconds;
+
     //
-    // Experimental waiter that will not run idle ticks.
-    // Not currently in use.
+    // This waiter is typically used for sparsely-active models, and does not
+    // run idle ticks.  When no work is due next tick, the engine records the
+    // earliest tick holding scheduled work, and this waiter advances the
+    // iteration count directly to that tick.  With wall-clock alignment,
+    // the skipped interval is slept in a single wait, so that model time
+    // still tracks wall-clock time; without it, the model runs ahead.
+    // NOTE: The external work source is not called for skipped ticks, and
+    //       if nothing at all is scheduled, no ticks are skipped, so the
+    //       external work source can still start new work.
     //
-    template<class OPERATORTYPE, class IMPLEMENTATIONTYPE>
+    template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
     class FirstWorkWaiter : public IModelEngineWaiter
     {
-        ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE>& context_;
-        ModelEngineContextOp<OPERATORTYPE, IMPLEMENTATIONTYPE> contextOp_;
-        time_point workCutoffTime_;
+        ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context_;
+        ModelEngineContextOp<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE> contextOp_;
+        time_point nextScheduledTick_;
+        bool waitForFirstTick { true };
 
     public:
-        virtual time_point GetWorkCutoffTime() override { return workCutoffTime_; }
-
-        FirstWorkWaiter(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE>& context) :
+        FirstWorkWaiter(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context) :
             context_(context),
             contextOp_(context),
-            workCutoffTime_(high_resolution_clock::now())
+            nextScheduledTick_(high_resolution_clock::now() + context_.EnginePeriod)
+        {
+
+        }
+
+        virtual bool WaitForWorkOrQuit() override
+        {
+            if (waitForFirstTick)
+            {
+                nextScheduledTick_ = high_resolution_clock::now() + context_.EnginePeriod;
+                waitForFirstTick = false;
+            }
+
+            auto skippedTicks = SkipIdleTicks();
+            if (context_.TickBudget > 0 && context_.Iterations >= context_.TickBudget)
+                return true;
+
+            if (!context_.KeepWallClockAlignment)
+                return contextOp_.QuitRequested();
+
+            nextScheduledTick_ += context_.EnginePeriod * skippedTicks;
+            auto quit = contextOp_.WaitForWorkOrQuit(nextScheduledTick_);
+            nextScheduledTick_ += context_.EnginePeriod;
+
+            return quit;
+        }
+
+    private:
+        //
+        // Advance the iteration count to the next tick with work to do,
+        // but not past the tick budget, if any.  Return the number of ticks skipped.
+        //
+        unsigned long long int SkipIdleTicks()
         {
+            auto nextTick = context_.NextScheduledTick;
+            if (nextTick == std::numeric_limits<unsigned long long int>::max()) return 0ULL;
+            if (context_.TickBudget > 0 && nextTick > context_.TickBudget) nextTick = context_.TickBudget;
+            if (nextTick <= context_.Iterations) return 0ULL;
+
+#ifndef NOLOG
+            context_.Logger.Write("Skipping idle ticks {} to {}\n", context_.Iterations, nextTick - 1);
+#endif
+
+            auto skippedTicks = nextTick - context_.Iterations;
+            context_.Iterations = nextTick;
 
+            return skippedTicks;
         }
     };
 }
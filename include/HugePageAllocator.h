@@ -0,0 +1,135 @@
+#pragma once
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+    using std::size_t;
+
+    constexpr size_t HugePageBytes { 2 * 1024 * 1024 };
+
+    //
+    // A standard allocator for large, long-lived arrays such as the model,
+    // which are indexed at random and so miss the TLB constantly on 4K pages.
+    // Allocations of at least one huge page are mapped directly, first from
+    // the explicit 2MB huge page pool, and if that is empty or not configured,
+    // as ordinary anonymous memory marked for transparent huge pages.  Where
+    // neither kind of huge page is available, the mapping simply stays on
+    // normal pages.  Smaller allocations come from the heap as usual.
+    //
+    template<class T>
+    class HugePageAllocator
+    {
+    public:
+        using value_type = T;
+
+        HugePageAllocator() noexcept = default;
+
+        template<class U>
+        HugePageAllocator(const HugePageAllocator<U>&) noexcept { }
+
+        T* allocate(size_t count)
+        {
+            auto bytes = count * sizeof(T);
+            if (bytes < HugePageBytes)
+                return static_cast<T*>(::operator new(bytes));
+
+            auto mappedBytes = MappedBytes(bytes);
+            auto* memory = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | HugeTlbFlags(), -1, 0);
+            if (memory == MAP_FAILED)
+            {
+                memory = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (memory == MAP_FAILED) throw std::bad_alloc();
+                AdviseHugePages(memory, mappedBytes);
+            }
+
+            return static_cast<T*>(memory);
+        }
+
+        void deallocate(T* memory, size_t count) noexcept
+        {
+            auto bytes = count * sizeof(T);
+            if (bytes < HugePageBytes)
+                ::operator delete(memory);
+            else
+                munmap(memory, MappedBytes(bytes));
+        }
+
+        template<class U>
+        bool operator==(const HugePageAllocator<U>&) const noexcept { return true; }
+
+        template<class U>
+        bool operator!=(const HugePageAllocator<U>&) const noexcept { return false; }
+
+        //
+        // Ask for transparent huge pages over the whole huge pages inside a range.
+        //
+        static void AdviseHugePages(void* memory, size_t bytes)
+        {
+            auto first = (reinterpret_cast<std::uintptr_t>(memory) + HugePageBytes - 1) / HugePageBytes * HugePageBytes;
+            auto last = (reinterpret_cast<std::uintptr_t>(memory) + bytes) / HugePageBytes * HugePageBytes;
+            if (first < last)
+                madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE);
+        }
+
+    private:
+        static size_t MappedBytes(size_t bytes)
+        {
+            return (bytes + HugePageBytes - 1) / HugePageBytes * HugePageBytes;
+        }
+
+        static int HugeTlbFlags()
+        {
+#ifdef MAP_HUGE_SHIFT
+            return MAP_HUGETLB | (21 << MAP_HUGE_SHIFT);
+#else
+            return MAP_HUGETLB;
+#endif
+        }
+    };
+
+    //
+    // A model container on huge pages.  A model carrier opts in by holding
+    // a ModelVector<NODETYPE>& in place of a vector<NODETYPE>&; indexing the
+    // model is unchanged.
+    //
+    template<class NODETYPE>
+    using ModelVector = vector<NODETYPE, HugePageAllocator<NODETYPE>>;
+
+    //
+    // Work buffers keep the standard allocator, since their iterators appear
+    // in every implementation's Process() signature.  Instead, whenever a
+    // buffer has grown into new storage, the huge pages inside it are marked
+    // for transparent huge pages.  Buffers that are swapped with each other
+    // trade storage every tick, so the last few advised storages are
+    // remembered, and only storage not seen recently costs a system call.
+    //
+    class HugePageAdvisor
+    {
+        static constexpr int RememberedStorageCount { 4 };
+
+        const void* advisedData_[RememberedStorageCount] { };
+        int nextSlot_ { 0 };
+
+    public:
+        template<class T>
+        void Advise(const vector<T>& buffer)
+        {
+            auto bytes = buffer.capacity() * sizeof(T);
+            if (bytes < HugePageBytes) return;
+
+            for (auto* advisedData : advisedData_)
+                if (advisedData == buffer.data()) return;
+
+            advisedData_[nextSlot_] = buffer.data();
+            nextSlot_ = (nextSlot_ + 1) % RememberedStorageCount;
+            HugePageAllocator<T>::AdviseHugePages(const_cast<T*>(buffer.data()), bytes);
+        }
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "WorkItem.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+
+    //
+    // Access to the work a partitioner is holding, so the pending work
+    // of a running model can be saved and later restored.
+    // Only call these at a tick boundary, while no worker thread is running.
+    //
+    template<class OPERATORTYPE>
+    struct IModelEngineBacklog
+    {
+        virtual ~IModelEngineBacklog() = default;
+
+        //
+        // Append a copy of all work held for ticks after the
+        // upcoming one, each item with its scheduled tick.
+        //
+        virtual void ExportBacklog(vector<WorkItem<OPERATORTYPE>>& backlog) = 0;
+
+        //
+        // Append a copy of any work for the upcoming tick that the
+        // partitioner holds itself, rather than handing it to the
+        // workers as ranges.
+        //
+        virtual void ExportWorkForTick(vector<WorkItem<OPERATORTYPE>>& /*workForTick*/) { }
+
+        //
+        // Take over restored work: the work for the upcoming tick is handed
+        // to the workers as if just partitioned, and the backlog is
+        // scheduled for later ticks.
+        //
+        virtual void ImportPendingWork(const vector<WorkItem<OPERATORTYPE>>& workForTick, const vector<WorkItem<OPERATORTYPE>>& backlog) = 0;
+    };
+}
@@ -30,5 +30,17 @@ namespace embeddedpenguins::modelengine
         // work back into the context of each worker.
         //
         virtual unsigned long int SingleThreadPartitionStep() = 0;
+
+        //
+        // The number of work items the partitioner is holding
+        // for ticks after the next one.
+        //
+        virtual unsigned long long int BacklogSize() = 0;
+
+        //
+        // The earliest tick of any work the partitioner is holding
+        // for ticks after the next one, or the maximum tick if none.
+        //
+        virtual unsigned long long int NextScheduledTick() = 0;
     };
 }
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <numeric>
+#include <algorithm>
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+    using std::string;
+
+    //
+    // The order in which the nodes of a two-dimensional grid model are stored.
+    //
+    enum class IndexOrder
+    {
+        RowMajor,
+        ZOrder,
+        Hilbert
+    };
+
+    //
+    // Map the cells of a width x height grid to the positions at which their
+    // nodes are stored in the model, and back.  Row-major storage keeps each
+    // row together, so a worker's stripe is a band of whole rows, and the
+    // rows above and below a cell are a full width away.  Storing the cells
+    // along a Z-order (Morton) or Hilbert curve keeps small square tiles of
+    // the grid together instead, so a stripe of storage is a compact tile,
+    // and most of a cell's neighbours are near it in memory.
+    //
+    // The index of an operation is the storage position, so the engine sorts
+    // and partitions by it unchanged; the model uses the layout to go between
+    // grid coordinates (or the row-major grid index, row * width + column)
+    // and storage.  Curve positions are ranked densely, so a grid of any
+    // shape fills exactly width * height nodes.  Nodes past the end of the
+    // grid map to themselves.
+    //
+    class IndexLayout
+    {
+        unsigned long int width_ { 0 };
+        unsigned long int height_ { 0 };
+        IndexOrder order_ { IndexOrder::RowMajor };
+
+        // Storage position of each row-major grid index, and the reverse.
+        // Empty for row-major order, where the two are the same.
+        vector<unsigned int> toStorage_ {};
+        vector<unsigned int> toGrid_ {};
+
+    public:
+        IndexLayout() = default;
+
+        IndexLayout(unsigned long int width, unsigned long int height, IndexOrder order = IndexOrder::RowMajor) :
+            width_(width),
+            height_(height),
+            order_(order)
+        {
+            if (order_ != IndexOrder::RowMajor && width_ > 0 && height_ > 0)
+                BuildTables();
+        }
+
+        const unsigned long int Width() const { return width_; }
+        const unsigned long int Height() const { return height_; }
+        const IndexOrder Order() const { return order_; }
+        const unsigned long long int Size() const { return static_cast<unsigned long long int>(width_) * height_; }
+
+        //
+        // Storage position of the cell at a row-major grid index.
+        //
+        unsigned long long int ToStorage(unsigned long long int gridIndex) const
+        {
+            if (toStorage_.empty() || gridIndex >= toStorage_.size()) return gridIndex;
+            return toStorage_[gridIndex];
+        }
+
+        unsigned long long int ToStorage(unsigned long long int row, unsigned long long int column) const
+        {
+            return ToStorage(row * width_ + column);
+        }
+
+        //
+        // Row-major grid index of the cell stored at a position.
+        //
+        unsigned long long int ToGrid(unsigned long long int storageIndex) const
+        {
+            if (toGrid_.empty() || storageIndex >= toGrid_.size()) return storageIndex;
+            return toGrid_[storageIndex];
+        }
+
+        unsigned long long int Row(unsigned long long int storageIndex) const { return width_ == 0 ? 0 : ToGrid(storageIndex) / width_; }
+        unsigned long long int Column(unsigned long long int storageIndex) const { return width_ == 0 ? 0 : ToGrid(storageIndex) % width_; }
+
+        //
+        // Parse the name of an order, leaving the order unchanged if the name is unknown.
+        //
+        static bool ParseIndexOrder(const string& name, IndexOrder& order)
+        {
+            if (name == "RowMajor") order = IndexOrder::RowMajor;
+            else if (name == "ZOrder") order = IndexOrder::ZOrder;
+            else if (name == "Hilbert") order = IndexOrder::Hilbert;
+            else return false;
+
+            return true;
+        }
+
+        //
+        // Interleave the bits of the column (even bits) and row (odd bits).
+        //
+        static unsigned long long int MortonKey(unsigned long long int column, unsigned long long int row)
+        {
+            return SpreadBits(column) | (SpreadBits(row) << 1);
+        }
+
+        //
+        // Distance along a Hilbert curve filling a square of side 2^bits.
+        //
+        static unsigned long long int HilbertKey(unsigned long long int column, unsigned long long int row, unsigned int bits)
+        {
+            auto side = 1ULL << bits;
+            auto key { 0ULL };
+            for (auto s = side >> 1; s > 0; s >>= 1)
+            {
+                auto rx = (column & s) != 0 ? 1ULL : 0ULL;
+                auto ry = (row & s) != 0 ? 1ULL : 0ULL;
+                key += s * s * ((3 * rx) ^ ry);
+
+                if (ry == 0)
+                {
+                    if (rx == 1)
+                    {
+                        column = side - 1 - column;
+                        row = side - 1 - row;
+                    }
+                    std::swap(column, row);
+                }
+            }
+
+            return key;
+        }
+
+    private:
+        void BuildTables()
+        {
+            auto size = Size();
+            auto bits { 0U };
+            while ((1ULL << bits) < std::max(width_, height_)) bits++;
+
+            vector<unsigned long long int> keys(size);
+            for (auto gridIndex = 0ULL; gridIndex < size; gridIndex++)
+            {
+                auto row = gridIndex / width_;
+                auto column = gridIndex % width_;
+                keys[gridIndex] = order_ == IndexOrder::ZOrder ? MortonKey(column, row) : HilbertKey(column, row, bits);
+            }
+
+            toGrid_.resize(size);
+            std::iota(begin(toGrid_), end(toGrid_), 0U);
+            std::sort(begin(toGrid_), end(toGrid_), [&keys](unsigned int lhs, unsigned int rhs) { return keys[lhs] < keys[rhs]; });
+
+            toStorage_.resize(size);
+            for (auto storageIndex = 0ULL; storageIndex < size; storageIndex++)
+                toStorage_[toGrid_[storageIndex]] = storageIndex;
+        }
+
+        static unsigned long long int SpreadBits(unsigned long long int value)
+        {
+            value &= 0xFFFFFFFFULL;
+            value = (value | (value << 16)) & 0x0000FFFF0000FFFFULL;
+            value = (value | (value << 8)) & 0x00FF00FF00FF00FFULL;
+            value = (value | (value << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+            value = (value | (value << 2)) & 0x3333333333333333ULL;
+            value = (value | (value << 1)) & 0x5555555555555555ULL;
+            return value;
+        }
+    };
+}
@@ -22,7 +22,7 @@ namespace embeddedpenguins::modelengine
 
     //
     // The top-level control engine for running a model.
-    // Create and run a single thread, which will create N worker objects, each
+    // When run, create a single thread, which will create N worker objects, each
     // with its own thread.  By default, N will be the number of hardware cores - 1
     // so that between the model engine thread and the worker thread, all cores
     // will be kept busy.
@@ -32,8 +32,9 @@ namespace embeddedpenguins::modelengine
     {
         ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE> context_;
         ModelEngineContextOp<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE> contextOp_;
+        unique_ptr<IModelEnginePartitioner> partitioner_ { };
+        unique_ptr<IModelEngineWaiter> waiter_ { };
         thread workerThread_;
-        PartitionPolicy partitionPolicy_ { PartitionPolicy::AdaptiveWidth };
         nanoseconds duration_ {};
         time_point startTime_ {};
 
@@ -42,10 +43,29 @@ namespace embeddedpenguins::modelengine
         const long long int GetTotalWork() const { return context_.TotalWork; }
         const long long int GetIterations() const { return context_.Iterations; }
         const nanoseconds GetDuration() const { return duration_; }
+        const nanoseconds GetRunTime() const { return context_.RunTime; }
+        const unsigned long long int GetCheckpoints() const { return context_.Checkpoints; }
+        const unsigned long long int GetCheckpointOverruns() const { return context_.CheckpointOverruns; }
+        const microseconds GetCheckpointStallTime() const { return context_.CheckpointStallTime; }
+        const microseconds GetCheckpointStallMax() const { return context_.CheckpointStallMax; }
         const string& LogFile() const { return context_.LogFile; }
         void LogFile(const string& logfile) { context_.LogFile = logfile; }
         const string& RecordFile() const { return context_.RecordFile; }
         void RecordFile(const string& recordfile) { context_.RecordFile = recordfile; }
+        const RecordFormat RecordFileFormat() const { return context_.RecordFileFormat; }
+        void RecordFileFormat(RecordFormat recordfileformat) { context_.RecordFileFormat = recordfileformat; }
+        const RecordSettings& Recording() const { return context_.Recording; }
+        RecordSettings& Recording() { return context_.Recording; }
+        const string& RestoreFile() const { return context_.RestoreFile; }
+        void RestoreFile(const string& restorefile) { context_.RestoreFile = restorefile; }
+        const string& CheckpointFile() const { return context_.CheckpointFile; }
+        void CheckpointFile(const string& checkpointfile) { context_.CheckpointFile = checkpointfile; }
+        const unsigned long long int CheckpointInterval() const { return context_.CheckpointInterval; }
+        void CheckpointInterval(unsigned long long int checkpointinterval) { context_.CheckpointInterval = checkpointinterval; }
+        const unsigned long long int CheckpointCompactAfter() const { return context_.CheckpointCompactAfter; }
+        void CheckpointCompactAfter(unsigned long long int checkpointcompactafter) { context_.CheckpointCompactAfter = checkpointcompactafter; }
+        const bool CheckpointInBackground() const { return context_.CheckpointInBackground; }
+        void CheckpointInBackground(bool checkpointinbackground) { context_.CheckpointInBackground = checkpointinbackground; }
         const microseconds EnginePeriod() const { return context_.EnginePeriod; }
         microseconds& EnginePeriod() { return context_.EnginePeriod; }
 
@@ -56,7 +76,6 @@ namespace embeddedpenguins::modelengine
             context_(configuration, helper),
             contextOp_(context_)
         {
-            CreateWorkerThread(helper);
         }
 
         ~ModelEngine()
@@ -69,6 +88,10 @@ namespace embeddedpenguins::modelengine
     public:
         void Run()
         {
+            // An engine runs only once.
+            if (context_.Run) return;
+
+            CreateWorkerThread(context_.Helper);
             context_.Run = true;
 
             while (!context_.EngineInitialized && !context_.EngineInitializeFailed)
@@ -80,6 +103,71 @@ namespace embeddedpenguins::modelengine
                 WaitForQuit();
         }
 
+        //
+        // Run exactly the given number of ticks, or stop early if
+        // requested when no more work is queued, without waiting
+        // for wall-clock tick boundaries.  If the first-work wait policy
+        // is configured, idle ticks are still skipped.  Return when the engine has stopped.
+        //
+        void RunTicks(unsigned long long int ticks, bool stopWhenIdle = false)
+        {
+            if (context_.Run) return;
+
+            context_.TickBudget = ticks;
+            context_.StopWhenIdle = stopWhenIdle;
+            context_.KeepWallClockAlignment = false;
+            if (context_.Waiting != WaitPolicy::FirstWork)
+                context_.Waiting = WaitPolicy::AsFastAsPossible;
+
+            Run();
+
+            if (workerThread_.joinable())
+                workerThread_.join();
+
+            duration_ = high_resolution_clock::now() - startTime_;
+        }
+
+        //
+        // Write the model, the tick and all pending work to a snapshot file,
+        // at the next tick boundary if the engine is running.  A new engine
+        // configured to restore from the file carries on from that tick.
+        // Return false if the engine has not initialized, or the write failed.
+        //
+        bool Snapshot(const string& path)
+        {
+            lock_guard<mutex> lock(context_.PartitioningMutex);
+            if (!context_.EngineInitialized) return false;
+
+            return contextOp_.WriteSnapshot(path);
+        }
+
+        //
+        // Write out the records kept in the flight-recorder rings, at the next
+        // tick boundary if the engine is running.  The rings are emptied,
+        // and keep recording.  Return false if the engine has not initialized.
+        //
+        bool DumpRecords()
+        {
+            lock_guard<mutex> lock(context_.PartitioningMutex);
+            if (!context_.EngineInitialized) return false;
+
+            contextOp_.DumpRecords();
+            return true;
+        }
+
+        //
+        // A consistent copy of the telemetry of the last tick run, safe to take
+        // from any thread while the engine runs, without pausing it.
+        // Empty until the engine has initialized.
+        //
+        EngineTelemetry GetTelemetry() const
+        {
+            EngineTelemetry telemetry {};
+            if (context_.EngineInitialized)
+                context_.Telemetry.Read(telemetry);
+            return telemetry;
+        }
+
         void Quit()
         {
             contextOp_.SignalQuit();
@@ -87,35 +175,57 @@ namespace embeddedpenguins::modelengine
 
         void WaitForQuit()
         {
+            if (!workerThread_.joinable()) return;
+
             auto endTime = high_resolution_clock::now();
             duration_ = endTime - startTime_;
 
             contextOp_.SignalQuit();
-
-            if (workerThread_.joinable())
-                workerThread_.join();
+            workerThread_.join();
         }
 
     private:
         void CreateWorkerThread(MODELHELPERTYPE& helper)
         {
-            unique_ptr<IModelEnginePartitioner> partitioner { };
-            switch (partitionPolicy_)
+            switch (context_.Partitioning)
             {
             case PartitionPolicy::ConstantWidth:
-                partitioner = make_unique<ConstantWidthPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                partitioner_ = make_unique<ConstantWidthPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
                 break;
             
             case PartitionPolicy::AdaptiveWidth:
-                partitioner = make_unique<AdaptiveWidthPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                partitioner_ = make_unique<AdaptiveWidthPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                break;
+            
+            case PartitionPolicy::OwnerRouted:
+                partitioner_ = make_unique<OwnerRoutedPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                break;
+            
+            case PartitionPolicy::CostWeighted:
+                partitioner_ = make_unique<CostWeightedPartitioner<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
                 break;
             
             default:
                 break;
             }
 
-            unique_ptr<IModelEngineWaiter> waiter = make_unique<ConstantTickWaiter<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
-            workerThread_ = thread(ModelEngineThread<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>(context_, helper, partitioner, waiter));
+            switch (context_.Waiting)
+            {
+            case WaitPolicy::AsFastAsPossible:
+                waiter_ = make_unique<AsFastAsPossibleWaiter<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                break;
+
+            case WaitPolicy::FirstWork:
+                waiter_ = make_unique<FirstWorkWaiter<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                break;
+
+            case WaitPolicy::ConstantTick:
+            default:
+                waiter_ = make_unique<ConstantTickWaiter<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(context_);
+                break;
+            }
+
+            workerThread_ = thread(ModelEngineThread<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>(context_, helper, *partitioner_, *waiter_));
         }
     };
 }
@@ -29,11 +29,22 @@ namespace embeddedpenguins
         using std::filesystem::create_directories;
 
         using nlohmann::json;
+
+        constexpr unsigned int DefaultCostRegions { 64 };
         
         enum class PartitionPolicy
         {
             ConstantWidth,
-            AdaptiveWidth
+            AdaptiveWidth,
+            OwnerRouted,
+            CostWeighted
+        };
+
+        enum class WaitPolicy
+        {
+            ConstantTick,
+            AsFastAsPossible,
+            FirstWork
         };
     }
 }
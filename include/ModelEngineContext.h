@@ -5,11 +5,19 @@
 #include <atomic>
 #include <vector>
 #include <mutex>
+#include <thread>
 #include <chrono>
 #include <condition_variable>
 
+#include <sys/types.h>
+
 #include "ConfigurationRepository.h"
 
+#include "IModelEngineBacklog.h"
+#include "DirtyBlockMap.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
+#include "EngineTelemetry.h"
 #include "Worker.h"
 #include "WorkerContext.h"
 #include "Log.h"
@@ -19,18 +27,22 @@ namespace embeddedpenguins::modelengine
     using std::string;
     using std::atomic;
     using std::mutex;
+    using std::thread;
     using std::condition_variable;
     using std::vector;
     using std::unique_ptr;
     using std::chrono::microseconds;
+    using std::chrono::nanoseconds;
 
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
 
-    using embeddedpenguins::core::neuron::model::Log;
     using embeddedpenguins::core::neuron::model::LogLevel;
 
     using embeddedpenguins::modelengine::threads::Worker;
     using embeddedpenguins::modelengine::threads::WorkerContext;
+    using embeddedpenguins::modelengine::threads::DefaultBarrierSpinCount;
+    using embeddedpenguins::modelengine::threads::DefaultChunksPerWorker;
+    using embeddedpenguins::modelengine::threads::DirtyBlockMap;
 
     //
     // Carry the public information defining the model engine.
@@ -48,20 +60,63 @@ namespace embeddedpenguins::modelengine
 
         const ConfigurationRepository& Configuration;
         MODELHELPERTYPE& Helper;
-        Log Logger {};
+        AsyncLog Logger {};
+        LogSink LogWriter {};
         LogLevel LoggingLevel { LogLevel::Status };
         string LogFile {"ModelEngine.log"};
         string RecordFile {"ModelEngineRecord.csv"};
+        RecordWriter<RECORDTYPE> RecordSink {};
+        RecordSettings Recording {};
+        RecordFormat RecordFileFormat { RecordFormat::Csv };
+        string RestoreFile {""};
+        string CheckpointFile {""};
+        unsigned long long int CheckpointInterval { 0ULL };
+        unsigned long long int CheckpointCompactAfter { 8ULL };
+        DirtyBlockMap DirtyBlocks {};
+        unsigned long long int CheckpointChain { 0ULL };
+        unsigned long long int CheckpointSequence { 0ULL };
+        unsigned long long int CheckpointSequenceCompacted { 0ULL };
+        bool CheckpointInBackground { true };
+        pid_t CheckpointWriter { 0 };
+        thread CheckpointCompactor {};
+        atomic<bool> CheckpointCompacting { false };
 
         vector<unique_ptr<Worker<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>> Workers {};
         WorkerContext<OPERATORTYPE, RECORDTYPE> ExternalWorkSource { Iterations, EnginePeriod, LoggingLevel };
+        IModelEngineBacklog<OPERATORTYPE>* Backlog { nullptr };
         int WorkerCount { 0 };
+        PartitionPolicy Partitioning { PartitionPolicy::AdaptiveWidth };
+        WaitPolicy Waiting { WaitPolicy::ConstantTick };
+        unsigned int BarrierSpinCount { DefaultBarrierSpinCount };
+        bool WorkStealing { false };
+        bool PinThreads { false };
+        bool SkipSmtSiblings { false };
+        vector<int> Cores { };
+        vector<int> PlacementCpus { };
+        bool FirstTouchModel { true };
+        bool HugePageWorkBuffers { false };
+        bool CoalesceWork { true };
+        double DenseFrontierFraction { DefaultDenseFrontierFraction };
+        unsigned int ChunksPerWorker { DefaultChunksPerWorker };
+        unsigned int CostRegions { DefaultCostRegions };
         microseconds EnginePeriod;
         atomic<bool> EngineInitialized { false };
         atomic<bool> EngineInitializeFailed { false };
         microseconds PartitionTime { };
         unsigned long long int Iterations { 0LL };
         long long int TotalWork { 0LL };
+        unsigned long long int TickBudget { 0LL };
+        bool StopWhenIdle { false };
+        unsigned long long int PendingWork { 0LL };
+        unsigned long long int NextScheduledTick { 0LL };
+        bool KeepWallClockAlignment { true };
+        nanoseconds RunTime { };
+        unsigned long long int Checkpoints { 0ULL };
+        unsigned long long int CheckpointOverruns { 0ULL };
+        microseconds CheckpointStallTime { };
+        microseconds CheckpointStallMax { };
+        TelemetryChannel Telemetry {};
+        vector<WorkerTelemetry> WorkerTicks {};
 
         ModelEngineContext(const ConfigurationRepository& configuration, MODELHELPERTYPE& helper) :
             Configuration(configuration),
@@ -81,6 +136,214 @@ namespace embeddedpenguins::modelengine
                 }
             }
 
+            if (Configuration.Configuration().contains("Execution"))
+            {
+                const json& executionJson = Configuration.Configuration()["Execution"];
+
+                if (executionJson.contains("PartitionPolicy"))
+                {
+                    const json& partitionPolicyJson = executionJson["PartitionPolicy"];
+                    if (partitionPolicyJson.is_string())
+                    {
+                        auto partitionPolicy = partitionPolicyJson.get<string>();
+                        if (partitionPolicy == "ConstantWidth") Partitioning = PartitionPolicy::ConstantWidth;
+                        else if (partitionPolicy == "AdaptiveWidth") Partitioning = PartitionPolicy::AdaptiveWidth;
+                        else if (partitionPolicy == "OwnerRouted") Partitioning = PartitionPolicy::OwnerRouted;
+                        else if (partitionPolicy == "CostWeighted") Partitioning = PartitionPolicy::CostWeighted;
+                    }
+                }
+
+                if (executionJson.contains("WaitPolicy"))
+                {
+                    const json& waitPolicyJson = executionJson["WaitPolicy"];
+                    if (waitPolicyJson.is_string())
+                    {
+                        auto waitPolicy = waitPolicyJson.get<string>();
+                        if (waitPolicy == "ConstantTick") Waiting = WaitPolicy::ConstantTick;
+                        else if (waitPolicy == "AsFastAsPossible") Waiting = WaitPolicy::AsFastAsPossible;
+                        else if (waitPolicy == "FirstWork") Waiting = WaitPolicy::FirstWork;
+                    }
+                }
+
+                if (executionJson.contains("KeepWallClockAlignment"))
+                {
+                    const json& keepWallClockAlignmentJson = executionJson["KeepWallClockAlignment"];
+                    if (keepWallClockAlignmentJson.is_boolean())
+                        KeepWallClockAlignment = keepWallClockAlignmentJson.get<bool>();
+                }
+
+                if (executionJson.contains("BarrierSpinCount"))
+                {
+                    const json& barrierSpinCountJson = executionJson["BarrierSpinCount"];
+                    if (barrierSpinCountJson.is_number_unsigned())
+                        BarrierSpinCount = barrierSpinCountJson.get<unsigned int>();
+                }
+
+                if (executionJson.contains("PinThreads"))
+                {
+                    const json& pinThreadsJson = executionJson["PinThreads"];
+                    if (pinThreadsJson.is_boolean())
+                        PinThreads = pinThreadsJson.get<bool>();
+                }
+
+                if (executionJson.contains("SkipSmtSiblings"))
+                {
+                    const json& skipSmtSiblingsJson = executionJson["SkipSmtSiblings"];
+                    if (skipSmtSiblingsJson.is_boolean())
+                        SkipSmtSiblings = skipSmtSiblingsJson.get<bool>();
+                }
+
+                if (executionJson.contains("FirstTouchModel"))
+                {
+                    const json& firstTouchModelJson = executionJson["FirstTouchModel"];
+                    if (firstTouchModelJson.is_boolean())
+                        FirstTouchModel = firstTouchModelJson.get<bool>();
+                }
+
+                if (executionJson.contains("RestoreFrom"))
+                {
+                    const json& restoreFromJson = executionJson["RestoreFrom"];
+                    if (restoreFromJson.is_string())
+                        RestoreFile = restoreFromJson.get<string>();
+                }
+
+                if (executionJson.contains("RecordBlockRecords"))
+                {
+                    const json& recordBlockRecordsJson = executionJson["RecordBlockRecords"];
+                    if (recordBlockRecordsJson.is_number_unsigned() && recordBlockRecordsJson.get<unsigned long long int>() > 0)
+                        Recording.BlockRecords = recordBlockRecordsJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("RecordMode"))
+                {
+                    const json& recordModeJson = executionJson["RecordMode"];
+                    if (recordModeJson.is_string())
+                    {
+                        auto recordMode = recordModeJson.get<string>();
+                        if (recordMode == "Stream") Recording.Mode = RecordMode::Stream;
+                        else if (recordMode == "Ring") Recording.Mode = RecordMode::Ring;
+                    }
+                }
+
+                if (executionJson.contains("RecordRingRecords"))
+                {
+                    const json& recordRingRecordsJson = executionJson["RecordRingRecords"];
+                    if (recordRingRecordsJson.is_number_unsigned() && recordRingRecordsJson.get<unsigned long long int>() > 0)
+                        Recording.RingRecords = recordRingRecordsJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("RecordRingTicks"))
+                {
+                    const json& recordRingTicksJson = executionJson["RecordRingTicks"];
+                    if (recordRingTicksJson.is_number_unsigned())
+                        Recording.RingTicks = recordRingTicksJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("RecordEveryTicks"))
+                {
+                    const json& recordEveryTicksJson = executionJson["RecordEveryTicks"];
+                    if (recordEveryTicksJson.is_number_unsigned() && recordEveryTicksJson.get<unsigned long long int>() > 0)
+                        Recording.EveryTicks = recordEveryTicksJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("RecordIndexSample"))
+                {
+                    const json& recordIndexSampleJson = executionJson["RecordIndexSample"];
+                    if (recordIndexSampleJson.is_number_unsigned() && recordIndexSampleJson.get<unsigned long long int>() > 0)
+                        Recording.IndexSample = recordIndexSampleJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("RecordFormat"))
+                {
+                    const json& recordFormatJson = executionJson["RecordFormat"];
+                    if (recordFormatJson.is_string())
+                    {
+                        auto recordFormat = recordFormatJson.get<string>();
+                        if (recordFormat == "Csv") RecordFileFormat = RecordFormat::Csv;
+                        else if (recordFormat == "Binary") RecordFileFormat = RecordFormat::Binary;
+                    }
+                }
+
+                if (executionJson.contains("CheckpointFile"))
+                {
+                    const json& checkpointFileJson = executionJson["CheckpointFile"];
+                    if (checkpointFileJson.is_string())
+                        CheckpointFile = checkpointFileJson.get<string>();
+                }
+
+                if (executionJson.contains("CheckpointInterval"))
+                {
+                    const json& checkpointIntervalJson = executionJson["CheckpointInterval"];
+                    if (checkpointIntervalJson.is_number_unsigned())
+                        CheckpointInterval = checkpointIntervalJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("CheckpointCompactAfter"))
+                {
+                    const json& checkpointCompactAfterJson = executionJson["CheckpointCompactAfter"];
+                    if (checkpointCompactAfterJson.is_number_unsigned())
+                        CheckpointCompactAfter = checkpointCompactAfterJson.get<unsigned long long int>();
+                }
+
+                if (executionJson.contains("CheckpointInBackground"))
+                {
+                    const json& checkpointInBackgroundJson = executionJson["CheckpointInBackground"];
+                    if (checkpointInBackgroundJson.is_boolean())
+                        CheckpointInBackground = checkpointInBackgroundJson.get<bool>();
+                }
+
+                if (executionJson.contains("HugePageWorkBuffers"))
+                {
+                    const json& hugePageWorkBuffersJson = executionJson["HugePageWorkBuffers"];
+                    if (hugePageWorkBuffersJson.is_boolean())
+                        HugePageWorkBuffers = hugePageWorkBuffersJson.get<bool>();
+                }
+
+                if (executionJson.contains("Cores"))
+                {
+                    const json& coresJson = executionJson["Cores"];
+                    if (coresJson.is_array())
+                        for (auto& coreJson : coresJson)
+                            if (coreJson.is_number_unsigned())
+                                Cores.push_back(coreJson.get<int>());
+                }
+
+                if (executionJson.contains("WorkStealing"))
+                {
+                    const json& workStealingJson = executionJson["WorkStealing"];
+                    if (workStealingJson.is_boolean())
+                        WorkStealing = workStealingJson.get<bool>();
+                }
+
+                if (executionJson.contains("ChunksPerWorker"))
+                {
+                    const json& chunksPerWorkerJson = executionJson["ChunksPerWorker"];
+                    if (chunksPerWorkerJson.is_number_unsigned() && chunksPerWorkerJson.get<unsigned int>() > 0)
+                        ChunksPerWorker = chunksPerWorkerJson.get<unsigned int>();
+                }
+
+                if (executionJson.contains("CostRegions"))
+                {
+                    const json& costRegionsJson = executionJson["CostRegions"];
+                    if (costRegionsJson.is_number_unsigned() && costRegionsJson.get<unsigned int>() > 0)
+                        CostRegions = costRegionsJson.get<unsigned int>();
+                }
+
+                if (executionJson.contains("CoalesceWork"))
+                {
+                    const json& coalesceWorkJson = executionJson["CoalesceWork"];
+                    if (coalesceWorkJson.is_boolean())
+                        CoalesceWork = coalesceWorkJson.get<bool>();
+                }
+
+                if (executionJson.contains("DenseFrontierFraction"))
+                {
+                    const json& denseFrontierFractionJson = executionJson["DenseFrontierFraction"];
+                    if (denseFrontierFractionJson.is_number() && denseFrontierFractionJson.get<double>() >= 0.0)
+                        DenseFrontierFraction = denseFrontierFractionJson.get<double>();
+                }
+            }
+
             RecordFile = Configuration.ComposeRecordPath();
             LogFile = Configuration.ExtractRecordDirectory() + LogFile;
         }
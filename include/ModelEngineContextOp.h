@@ -2,9 +2,23 @@
 
 #include <iostream>
 #include <chrono>
+#include <limits>
+#include <vector>
+#include <thread>
+#include <cerrno>
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "ModelEngineCommon.h"
 #include "ModelEngineContext.h"
 #include "Worker.h"
+#include "WorkerContextOp.h"
+#include "CpuPlacement.h"
+#include "FirstTouch.h"
+#include "sdk/SnapshotPersister.h"
+#include "sdk/CheckpointPersister.h"
 #include "Log.h"
 
 namespace embeddedpenguins::modelengine
@@ -13,8 +27,21 @@ namespace embeddedpenguins::modelengine
     using std::lock_guard;
     using std::unique_lock;
     using std::make_unique;
+    using std::vector;
+    using std::thread;
+    using std::chrono::high_resolution_clock;
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
     using time_point = std::chrono::high_resolution_clock::time_point;
 
+    using embeddedpenguins::modelengine::threads::WorkerContextOp;
+    using embeddedpenguins::modelengine::threads::CpuPlacement;
+    using embeddedpenguins::modelengine::threads::FirstTouch;
+    using embeddedpenguins::modelengine::threads::CurrentBufferType;
+    using embeddedpenguins::neuron::infrastructure::persistence::SnapshotPersister;
+    using embeddedpenguins::neuron::infrastructure::persistence::SnapshotWork;
+    using embeddedpenguins::neuron::infrastructure::persistence::CheckpointPersister;
+
     //
     // Separate the executable code from the context carrier object so that the
     // context carrier object may be passed around without exposing methods.
@@ -31,6 +58,22 @@ namespace embeddedpenguins::modelengine
 
         }
 
+        //
+        // Move each worker's stripe of the newly allocated model onto the
+        // memory node of the CPU that worker will run on.  Workers that are
+        // not pinned may run on any node, so then the model is left as allocated.
+        //
+        bool SpreadModelOverWorkerNodes(MODELHELPERTYPE& helper)
+        {
+            if (!context_.FirstTouchModel || !context_.PinThreads) return false;
+
+            vector<int> stripeCpus {};
+            for (auto id = 1; id <= context_.WorkerCount; id++)
+                stripeCpus.push_back(CpuForWorker(id));
+
+            return FirstTouch::SpreadModel(helper.Model().Model, stripeCpus);
+        }
+
         void CreateWorkers(MODELHELPERTYPE& helper)
         {
             auto segmentSize = helper.Model().ModelSize() / context_.WorkerCount;
@@ -46,7 +89,9 @@ namespace embeddedpenguins::modelengine
                         segmentStart, 
                         segmentStart + segmentSize,
                         context_.Iterations,
-                        context_.LoggingLevel));
+                        context_.LoggingLevel,
+                        context_.BarrierSpinCount,
+                        CpuForWorker(id)));
             }
             context_.Workers.push_back(
                 make_unique<Worker<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(
@@ -57,13 +102,63 @@ namespace embeddedpenguins::modelengine
                     segmentStart, 
                     helper.Model().ModelSize(),
                     context_.Iterations,
-                    context_.LoggingLevel));
+                    context_.LoggingLevel,
+                    context_.BarrierSpinCount,
+                    CpuForWorker(context_.WorkerCount)));
 
             context_.ExternalWorkSource.Logger.SetId(context_.WorkerCount + 1);
             context_.ExternalWorkSource.EnginePeriod = context_.EnginePeriod;
             context_.ExternalWorkSource.WorkerId = context_.WorkerCount + 1;
             context_.ExternalWorkSource.RangeBegin = 0LL;
             context_.ExternalWorkSource.RangeEnd = helper.Model().ModelSize();
+
+            for (auto& worker : context_.Workers)
+                worker->GetContext().HugePageWorkBuffers = context_.HugePageWorkBuffers;
+
+            context_.WorkerTicks.resize(context_.Workers.size());
+            context_.Telemetry.Resize(context_.Workers.size());
+
+            // Incremental checkpoints write only the blocks the workers have touched.
+            if (!context_.CheckpointFile.empty() && context_.CheckpointInterval > 0)
+            {
+                context_.DirtyBlocks.Resize(helper.Model().ModelSize(), sizeof(helper.Model().Model[0]));
+                for (auto& worker : context_.Workers)
+                    worker->GetContext().DirtyBlocks = &context_.DirtyBlocks;
+            }
+
+            // The adaptive partitioners merge next-tick work that each worker has sorted by index.
+            if (context_.Partitioning == PartitionPolicy::AdaptiveWidth || context_.Partitioning == PartitionPolicy::CostWeighted)
+                for (auto& worker : context_.Workers)
+                    worker->GetContext().PresortIndexLimit = helper.Model().ModelSize();
+
+            // Stealing needs work grouped by index, which only the adaptive partitioners provide.
+            if (context_.WorkStealing && context_.Partitioning != PartitionPolicy::AdaptiveWidth && context_.Partitioning != PartitionPolicy::CostWeighted)
+                context_.WorkStealing = false;
+
+            if (context_.WorkStealing)
+            {
+                // Each worker tries its neighbors in turn, so thieves spread out over victims.
+                auto workerCount = context_.Workers.size();
+                for (auto thief = 0ULL; thief < workerCount; thief++)
+                    for (auto offset = 1ULL; offset < workerCount; offset++)
+                        context_.Workers[thief]->GetContext().StealFrom.push_back(&context_.Workers[(thief + offset) % workerCount]->GetContext());
+            }
+
+            if (context_.Partitioning == PartitionPolicy::OwnerRouted)
+            {
+                for (auto& worker : context_.Workers)
+                    WorkerContextOp<OPERATORTYPE, RECORDTYPE>(worker->GetContext()).RouteWorkToOwners(context_.WorkerCount, segmentSize);
+                WorkerContextOp<OPERATORTYPE, RECORDTYPE>(context_.ExternalWorkSource).RouteWorkToOwners(context_.WorkerCount, segmentSize);
+            }
+        }
+
+        //
+        // The CPU a worker is pinned to, or -1 if threads are not pinned.
+        //
+        int CpuForWorker(int workerId)
+        {
+            if (!context_.PinThreads) return -1;
+            return CpuPlacement::CpuForThread(context_.PlacementCpus, workerId);
         }
 
         void SignalQuit()
@@ -75,6 +170,239 @@ namespace embeddedpenguins::modelengine
             context_.Cv.notify_one();
         }
 
+        bool QuitRequested()
+        {
+            lock_guard<mutex> lock(context_.Mutex);
+            return context_.Quit;
+        }
+
+        //
+        // Count the future work created by all workers and the external
+        // work source that has not yet been taken by the partitioner.
+        //
+        unsigned long long int UnscheduledFutureWork()
+        {
+            unsigned long long int futureWork { 0ULL };
+            for (auto& worker : context_.Workers)
+                futureWork += worker->GetContext().WorkForFutureTicks1.size() + worker->GetContext().WorkForFutureTicks2.size();
+            futureWork += context_.ExternalWorkSource.WorkForFutureTicks1.size() + context_.ExternalWorkSource.WorkForFutureTicks2.size();
+
+            return futureWork;
+        }
+
+        //
+        // Find the earliest tick of the future work created by all workers and
+        // the external work source that has not yet been taken by the partitioner,
+        // or the maximum tick if there is none.
+        //
+        unsigned long long int EarliestUnscheduledFutureTick()
+        {
+            auto earliestTick = std::numeric_limits<unsigned long long int>::max();
+            auto findEarliest = [&earliestTick](const vector<WorkItem<OPERATORTYPE>>& futureWork)
+            {
+                for (auto& work : futureWork)
+                    if (work.Tick < earliestTick) earliestTick = work.Tick;
+            };
+
+            for (auto& worker : context_.Workers)
+            {
+                findEarliest(worker->GetContext().WorkForFutureTicks1);
+                findEarliest(worker->GetContext().WorkForFutureTicks2);
+            }
+            findEarliest(context_.ExternalWorkSource.WorkForFutureTicks1);
+            findEarliest(context_.ExternalWorkSource.WorkForFutureTicks2);
+
+            return earliestTick;
+        }
+
+        //
+        // Hand every recorder's flight-recorder ring to the record writer.
+        // Call only at a tick boundary, while holding the partitioning mutex.
+        //
+        void DumpRecords()
+        {
+            for (auto& worker : context_.Workers)
+                worker->GetContext().Record.Dump();
+            context_.ExternalWorkSource.Record.Dump();
+        }
+
+        //
+        // Write the model, the tick and all pending work to a snapshot file.
+        // Call only at a tick boundary, while holding the partitioning mutex.
+        //
+        bool WriteSnapshot(const string& path)
+        {
+            SnapshotWork<OPERATORTYPE> work {};
+            CapturePendingWork(work);
+
+            SnapshotPersister<OPERATORTYPE, MODELHELPERTYPE> persister(path);
+            return persister.Write(context_.Helper, context_.Iterations, context_.TotalWork, work);
+        }
+
+        //
+        // Write the next checkpoint of the chain: a full base for the first,
+        // then a delta of the blocks changed since the checkpoint before.
+        // In the background, the engine forks at the tick boundary and the
+        // child process writes the checkpoint from its copy-on-write image
+        // of the model and work, while this process carries on ticking.
+        // Only one checkpoint is written at a time; if the one before is
+        // still being written when the next is due, the tick waits for it.
+        // A failed delta has already consumed its dirty blocks, so the chain
+        // is abandoned and the next checkpoint starts a new one.  Once enough
+        // deltas have built up, they are compacted into the base on a thread
+        // of their own.  The time the tick loop is held up is measured.
+        // Call only at a tick boundary, while holding the partitioning mutex.
+        //
+        bool WriteCheckpoint()
+        {
+            auto checkpointStartTime = high_resolution_clock::now();
+
+            FinishBackgroundCheckpoint();
+
+            vector<unsigned long long int> blocks {};
+            context_.DirtyBlocks.TakeDirtyBlocks(blocks);
+
+            if (context_.CheckpointChain == 0ULL)
+            {
+                // A new base must not race a compaction still writing the old one.
+                JoinCompaction();
+
+                context_.CheckpointChain = NewCheckpointChain();
+                context_.CheckpointSequence = 0ULL;
+                context_.CheckpointSequenceCompacted = 0ULL;
+            }
+            else
+            {
+                ++context_.CheckpointSequence;
+            }
+
+            auto written = (context_.CheckpointInBackground && StartBackgroundCheckpoint(blocks)) || WriteCheckpointFiles(blocks);
+            if (!written)
+                context_.CheckpointChain = 0ULL;
+            else if (context_.CheckpointSequence > 0 && context_.CheckpointCompactAfter > 0 && context_.CheckpointSequence - context_.CheckpointSequenceCompacted >= context_.CheckpointCompactAfter)
+                StartCompaction();
+
+            auto checkpointStall = duration_cast<microseconds>(high_resolution_clock::now() - checkpointStartTime);
+            ++context_.Checkpoints;
+            context_.CheckpointStallTime += checkpointStall;
+            context_.CheckpointStallMax = std::max(context_.CheckpointStallMax, checkpointStall);
+            if (checkpointStall > context_.EnginePeriod) ++context_.CheckpointOverruns;
+
+            return written;
+        }
+
+        //
+        // Wait for the checkpoint being written in the background, if any.
+        // If it failed, the chain it belonged to is abandoned.
+        //
+        bool FinishBackgroundCheckpoint()
+        {
+            if (context_.CheckpointWriter <= 0) return true;
+
+            int status { 0 };
+            while (waitpid(context_.CheckpointWriter, &status, 0) < 0 && errno == EINTR) { }
+            context_.CheckpointWriter = 0;
+
+            if (WIFEXITED(status) && WEXITSTATUS(status) == 0) return true;
+
+            cout << "ModelEngine could not write checkpoint " << context_.CheckpointFile << " in the background\n";
+            context_.CheckpointChain = 0ULL;
+            return false;
+        }
+
+        //
+        // Compact the checkpoint chain in the background, unless a compaction
+        // is already running.
+        //
+        void StartCompaction()
+        {
+            if (context_.CheckpointCompacting) return;
+            JoinCompaction();
+
+            context_.CheckpointSequenceCompacted = context_.CheckpointSequence;
+            context_.CheckpointCompacting = true;
+            context_.CheckpointCompactor = thread([path = context_.CheckpointFile, &compacting = context_.CheckpointCompacting]()
+                {
+                    CheckpointPersister<OPERATORTYPE, MODELHELPERTYPE> checkpoint(path);
+                    if (!checkpoint.Compact())
+                        cout << "ModelEngine could not compact checkpoint " << path << '\n';
+                    compacting = false;
+                });
+        }
+
+        void JoinCompaction()
+        {
+            if (context_.CheckpointCompactor.joinable())
+                context_.CheckpointCompactor.join();
+        }
+
+        //
+        // Gather all work pending at a tick boundary: the work handed to each
+        // worker for the upcoming tick, the partitioner's backlog, and the work
+        // each worker and the external work source have created but not yet
+        // handed over.
+        //
+        void CapturePendingWork(SnapshotWork<OPERATORTYPE>& work)
+        {
+            for (auto& worker : context_.Workers)
+            {
+                auto& workForThread = worker->GetContext().WorkForThread;
+                work.WorkForTick.insert(end(work.WorkForTick), workForThread.begin(), workForThread.end());
+                CaptureUnhandedWork(worker->GetContext(), work);
+            }
+            CaptureUnhandedWork(context_.ExternalWorkSource, work);
+
+            if (context_.Backlog)
+            {
+                context_.Backlog->ExportWorkForTick(work.WorkForTick);
+                context_.Backlog->ExportBacklog(work.Backlog);
+            }
+        }
+
+        //
+        // Next-tick work lives in one buffer, or in one outbox per owner,
+        // and future work in whichever of two buffers the worker last wrote.
+        //
+        void CaptureUnhandedWork(WorkerContext<OPERATORTYPE, RECORDTYPE>& source, SnapshotWork<OPERATORTYPE>& work)
+        {
+            work.NextTickWork.insert(end(work.NextTickWork), begin(source.WorkForTick1), end(source.WorkForTick1));
+            for (auto& outbox : source.WorkForTick1ByOwner)
+                work.NextTickWork.insert(end(work.NextTickWork), begin(outbox), end(outbox));
+
+            work.FutureWork.insert(end(work.FutureWork), begin(source.WorkForFutureTicks1), end(source.WorkForFutureTicks1));
+            work.FutureWork.insert(end(work.FutureWork), begin(source.WorkForFutureTicks2), end(source.WorkForFutureTicks2));
+        }
+
+        //
+        // Restore the tick and pending work of a snapshot, after the workers are created.
+        // Work that had not been handed over is queued in the external work
+        // source, in the buffers the partitioner takes from next.
+        //
+        void RestorePendingWork(const SnapshotWork<OPERATORTYPE>& work, unsigned long long int iterations, unsigned long long int totalWork)
+        {
+            context_.Iterations = iterations;
+            if (context_.Backlog) context_.Backlog->ImportPendingWork(work.WorkForTick, work.Backlog);
+
+            auto& external = context_.ExternalWorkSource;
+            auto& futureWork = (external.CurrentBuffer == CurrentBufferType::Buffer2Current) ? external.WorkForFutureTicks1 : external.WorkForFutureTicks2;
+            futureWork.insert(end(futureWork), begin(work.FutureWork), end(work.FutureWork));
+
+            for (auto& nextTickWork : work.NextTickWork)
+            {
+                if (external.WorkForTick1ByOwner.empty())
+                {
+                    external.WorkForTick1.push_back(nextTickWork);
+                    continue;
+                }
+
+                auto owner = static_cast<unsigned long long int>(nextTickWork.Operator.Index) / external.OwnerStripeWidth;
+                if (owner >= external.WorkForTick1ByOwner.size()) owner = external.WorkForTick1ByOwner.size() - 1;
+                external.WorkForTick1ByOwner[owner].push_back(nextTickWork);
+            }
+
+            context_.TotalWork = totalWork;
+        }
+
         bool WaitForWorkOrQuit(time_point time)
         {
             //context_.Logger.Logger() << "WaitForWorkOrQuit() waiting until " << Log::FormatTime(time) << "\n";
@@ -94,5 +422,47 @@ namespace embeddedpenguins::modelengine
 
             return context_.Quit;
         }
+
+    private:
+        //
+        // Fork a child process to write the current checkpoint, and return
+        // false if it could not be started.  The child shares nothing with
+        // the running model after the fork, and leaves without running any
+        // of this process's exit handlers.
+        //
+        bool StartBackgroundCheckpoint(const vector<unsigned long long int>& blocks)
+        {
+            auto writer = fork();
+            if (writer < 0) return false;
+
+            if (writer == 0)
+                _exit(WriteCheckpointFiles(blocks) ? 0 : 1);
+
+            context_.CheckpointWriter = writer;
+            return true;
+        }
+
+        //
+        // Write the base of the current chain, or its current delta.
+        //
+        bool WriteCheckpointFiles(const vector<unsigned long long int>& blocks)
+        {
+            SnapshotWork<OPERATORTYPE> work {};
+            CapturePendingWork(work);
+
+            CheckpointPersister<OPERATORTYPE, MODELHELPERTYPE> checkpoint(context_.CheckpointFile);
+            if (context_.CheckpointSequence == 0ULL)
+                return checkpoint.WriteBase(context_.Helper, context_.Iterations, context_.TotalWork, work, context_.CheckpointChain);
+
+            return checkpoint.WriteDelta(context_.Helper, context_.Iterations, context_.TotalWork, work, context_.CheckpointChain, context_.CheckpointSequence, blocks, context_.DirtyBlocks.BlockNodes());
+        }
+
+        //
+        // Chain ids only need to differ between runs writing the same checkpoint.
+        //
+        static unsigned long long int NewCheckpointChain()
+        {
+            return static_cast<unsigned long long int>(std::chrono::system_clock::now().time_since_epoch().count()) | 1ULL;
+        }
     };
 }
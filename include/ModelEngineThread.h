@@ -6,18 +6,25 @@
 #include <vector>
 #include <thread>
 #include <limits>
+#include <algorithm>
+#include <sstream>
 
 #include "sdk/ModelInitializerProxy.h"
+#include "sdk/SnapshotPersister.h"
+#include "sdk/CheckpointPersister.h"
 
 #include "ModelEngineCommon.h"
 #include "ModelEngineContextOp.h"
 #include "AdaptiveWidthPartitioner.h"
 #include "ConstantWidthPartitioner.h"
+#include "OwnerRoutedPartitioner.h"
+#include "CostWeightedPartitioner.h"
 #include "ConstantTickWaiter.h"
+#include "AsFastAsPossibleWaiter.h"
+#include "FirstWorkWaiter.h"
 #include "Worker.h"
 #include "ProcessCallback.h"
 #include "Log.h"
-#include "Recorder.h"
 
 namespace embeddedpenguins::modelengine
 {
@@ -28,18 +35,20 @@ namespace embeddedpenguins::modelengine
     using std::chrono::high_resolution_clock;
     using std::chrono::milliseconds;
     using std::chrono::microseconds;
+    using std::chrono::nanoseconds;
     using std::chrono::duration_cast;
     using std::numeric_limits;
     using std::cout;
     using std::cerr;
 
-    using embeddedpenguins::core::neuron::model::Log;
-    using embeddedpenguins::core::neuron::model::Recorder;
     using embeddedpenguins::core::neuron::model::ModelInitializerProxy;
 
     using embeddedpenguins::modelengine::threads::Worker;
     using embeddedpenguins::modelengine::threads::WorkCode;
     using embeddedpenguins::modelengine::threads::ProcessCallback;
+    using embeddedpenguins::modelengine::threads::CpuPlacement;
+    using embeddedpenguins::neuron::infrastructure::persistence::CheckpointPersister;
+    using embeddedpenguins::neuron::infrastructure::persistence::SnapshotWork;
 
     //
     // The model engine does its work in this thread object.
@@ -52,8 +61,8 @@ namespace embeddedpenguins::modelengine
     template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
     class ModelEngineThread
     {
-        unique_ptr<IModelEngineWaiter> waiter_ { };
-        unique_ptr<IModelEnginePartitioner> partitioner_ { };
+        IModelEngineWaiter& waiter_;
+        IModelEnginePartitioner& partitioner_;
 
         ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context_;
         ModelEngineContextOp<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE> contextOp_;
@@ -66,10 +75,10 @@ namespace embeddedpenguins::modelengine
         ModelEngineThread(
                         ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context, 
                         MODELHELPERTYPE& helper, 
-                        unique_ptr<IModelEnginePartitioner>& partitioner, 
-                        unique_ptr<IModelEngineWaiter>& waiter) :
-            waiter_(std::move(waiter)),
-            partitioner_(std::move(partitioner)),
+                        IModelEnginePartitioner& partitioner, 
+                        IModelEngineWaiter& waiter) :
+            waiter_(waiter),
+            partitioner_(partitioner),
             context_(context),
             contextOp_(context),
             helper_(helper),
@@ -78,14 +87,19 @@ namespace embeddedpenguins::modelengine
         {
             context_.Logger.SetId(0);
 
+            // Size the workers to the CPUs this process may use, leaving one for this thread.
+            context_.PlacementCpus = CpuPlacement::UsableCpus(context_.Cores, context_.SkipSmtSiblings);
             if (context_.WorkerCount == 0)
-                context_.WorkerCount = std::thread::hardware_concurrency() - 1;
+                context_.WorkerCount = std::max(1, static_cast<int>(context_.PlacementCpus.size()) - 1);
         }
 
         void operator() ()
         {
             while (!context_.Run) { std::this_thread::yield(); }
 
+            if (context_.PinThreads && !CpuPlacement::PinCurrentThread(CpuPlacement::CpuForThread(context_.PlacementCpus, 0)))
+                cout << "ModelEngine could not be pinned to cpu " << CpuPlacement::CpuForThread(context_.PlacementCpus, 0) << '\n';
+
             try
             {
                 if (Initialize())
@@ -97,19 +111,8 @@ namespace embeddedpenguins::modelengine
                 cout << "ModelEngine exception while running: " << e.what() << '\n';
             }
 
-            Log::Merge(context_.ExternalWorkSource.Logger);
-            Log::Merge(context_.Logger);
-            for (auto& worker : context_.Workers)
-            {
-                Log::Merge(worker->GetContext().Logger);
-                Recorder<RECORDTYPE>::Merge(worker->GetContext().Record);
-            }
-            cout << "Writing log file to " << context_.LogFile << "... " << std::flush;
-            Log::Print(context_.LogFile.c_str());
-            cout << "Done\n";
-            cout << "Writing record file to " << context_.RecordFile << "... " << std::flush;
-            Recorder<RECORDTYPE>::Print(context_.RecordFile.c_str());
-            cout << "Done\n";
+            FinishLogging();
+            FinishRecording();
         }
 
         unsigned long long int GetIterations()
@@ -126,53 +129,165 @@ namespace embeddedpenguins::modelengine
                 return false;
             }
 
-            if (!InitializeModel())
+            // A model restored from a snapshot replaces both the initializer and any warm-up ticks.
+            // A checkpoint restores as its base with all the deltas that follow it.
+            auto restoring = !context_.RestoreFile.empty();
+            CheckpointPersister<OPERATORTYPE, MODELHELPERTYPE> snapshot(context_.RestoreFile);
+            if (restoring)
+            {
+                if (!snapshot.LoadConfiguration())
+                {
+                    cout << "Unable to load snapshot " << context_.RestoreFile << ", cannot restore\n";
+                    context_.EngineInitializeFailed = true;
+                    return false;
+                }
+
+                helper_.Model().Model.resize(snapshot.ModelSize());
+            }
+
+            // Initialize the model only after its pages are spread over the workers' nodes.
+            contextOp_.SpreadModelOverWorkerNodes(helper_);
+
+            if (restoring ? !snapshot.ReadModel(helper_, context_.Configuration) : !InitializeModel())
             {
                 context_.EngineInitializeFailed = true;
                 return false;
             }
 
             contextOp_.CreateWorkers(helper_);
+            ReportPlacement();
+            StartLogging();
+            StartRecording();
 
             context_.Iterations = 0ULL;
+            if (restoring)
+                RestorePendingWork(snapshot);
+
+            auto initializedTime = high_resolution_clock::now();
+            PublishTelemetry(initializedTime, initializedTime, nanoseconds { });
             context_.EngineInitialized = true;
 
             return true;
         }
 
+        //
+        // Pick up at the tick the snapshot was taken, with its pending work.
+        // A tick budget counts the ticks run from there.
+        //
+        void RestorePendingWork(CheckpointPersister<OPERATORTYPE, MODELHELPERTYPE>& snapshot)
+        {
+            SnapshotWork<OPERATORTYPE> work {};
+            snapshot.ReadWork(work);
+            contextOp_.RestorePendingWork(work, snapshot.Iterations(), snapshot.TotalWork());
+
+            if (context_.TickBudget > 0)
+                context_.TickBudget += context_.Iterations;
+
+            cout << "ModelEngine restored " << context_.RestoreFile << " at tick " << context_.Iterations << '\n';
+        }
+
+        //
+        // Log messages are formatted and written to the log file in the background as the model runs.
+        //
+        void StartLogging()
+        {
+            if (!context_.LogWriter.Open(context_.LogFile))
+            {
+                cout << "Unable to open log file " << context_.LogFile << ", messages will not be kept\n";
+                return;
+            }
+
+            context_.LogWriter.Attach(context_.Logger);
+            context_.LogWriter.Attach(context_.ExternalWorkSource.Logger);
+            for (auto& worker : context_.Workers)
+                context_.LogWriter.Attach(worker->GetContext().Logger);
+        }
+
+        //
+        // Only the messages not yet drained remain to be written.
+        //
+        void FinishLogging()
+        {
+            if (!context_.LogWriter.IsOpen()) return;
+
+            cout << "Flushing log file to " << context_.LogWriter.Path() << "... " << std::flush;
+            context_.LogWriter.Close();
+            cout << (context_.LogWriter.Failed() ? "Failed\n" : "Done\n");
+        }
+
+        //
+        // Records are written to the record file in the background as the model runs.
+        //
+        void StartRecording()
+        {
+            if (!context_.RecordSink.Open(context_.RecordFile, context_.RecordFileFormat))
+            {
+                cout << "Unable to open record file " << context_.RecordFile << ", records will not be kept\n";
+                return;
+            }
+
+            for (auto& worker : context_.Workers)
+                worker->GetContext().Record.Attach(context_.RecordSink, context_.Recording);
+            context_.ExternalWorkSource.Record.Attach(context_.RecordSink, context_.Recording);
+        }
+
+        //
+        // Only the records not yet handed to the writer remain to be written.
+        //
+        void FinishRecording()
+        {
+            if (!context_.RecordSink.IsOpen()) return;
+
+            cout << "Flushing record file to " << context_.RecordSink.Path() << "... " << std::flush;
+            for (auto& worker : context_.Workers)
+                worker->GetContext().Record.Flush();
+            context_.ExternalWorkSource.Record.Flush();
+            context_.RecordSink.Close();
+
+            if (context_.RecordSink.Failed())
+                cout << "Failed after " << context_.RecordSink.RecordsWritten() << " records\n";
+            else
+                cout << "Done, " << context_.RecordSink.RecordsWritten() << " records\n";
+        }
+
         void MainLoop()
         {
             auto engineStartTime = high_resolution_clock::now();
 #ifndef NOLOG
-            context_.Logger.Logger() << "ModelEngine starting main loop\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("ModelEngine starting main loop\n");
 #endif
 
             auto quit {false};
             do
             {
-                quit = WaitForWorkOrQuit();
+                quit = TickBudgetSpent() || WaitForWorkOrQuit();
                 if (!quit)
                 {
                     lock_guard<mutex> lock(context_.PartitioningMutex);
         
+                    auto tickStartTime = high_resolution_clock::now();
                     StartWorkWithAllWorkers();
-                    partitioner_->ConcurrentPartitionStep();
+                    partitioner_.ConcurrentPartitionStep();
+                    WorkSource_.Scratch().Reset();
+                    context_.ExternalWorkSource.Tally.ItemsEmitted = 0ULL;
                     WorkSource_.StreamNewInputWork(context_.ExternalWorkSource.Logger, context_.ExternalWorkSource.Record, context_.Iterations, callback_);
                     WaitForAllWorkersToCompleteWork();
-                    PartitionWork();
+                    auto workersDoneTime = high_resolution_clock::now();
+                    auto partitionTime = PartitionWork();
 
                     SwitchWorkingBuffersForAllWorkers();
                     ++context_.Iterations;
+                    CheckpointIfDue();
+                    PublishTelemetry(tickStartTime, workersDoneTime, partitionTime);
                 } 
             }
             while (!quit);
-            auto engineElapsed = duration_cast<microseconds>(high_resolution_clock::now() - engineStartTime).count();
+            context_.RunTime = high_resolution_clock::now() - engineStartTime;
+            auto engineElapsed = duration_cast<microseconds>(context_.RunTime).count();
             auto partitionElapsed = context_.PartitionTime.count();
 
 #ifndef NOLOG
-            context_.Logger.Logger() << "ModelEngine quitting main loop\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("ModelEngine quitting main loop\n");
 #endif
 
             double partitionRatio = (double)partitionElapsed / (double)engineElapsed;
@@ -182,12 +297,102 @@ namespace embeddedpenguins::modelengine
                 << " items  Partition Time: " << partitionElapsed << '/' << engineElapsed << " us = " 
                 << partitionRatio 
                 << "\n";
+
+            if (context_.Checkpoints > 0)
+                cout 
+                    << "Checkpoints: " << context_.Checkpoints 
+                    << " Stall: " << context_.CheckpointStallTime.count() << " us total, " 
+                    << context_.CheckpointStallMax.count() << " us max, " 
+                    << context_.CheckpointOverruns << " ticks overrun\n";
+        }
+
+        //
+        // A batch run stops by itself when it has run its budget of ticks,
+        // or optionally when no work is queued for any future tick.
+        // Work that the external work source has yet to stream in is not
+        // counted as queued.
+        //
+        bool TickBudgetSpent()
+        {
+            if (context_.TickBudget > 0 && context_.Iterations >= context_.TickBudget)
+                return true;
+
+            return context_.StopWhenIdle && context_.Iterations > 0 && context_.PendingWork == 0;
+        }
+
+        //
+        // Gather what each worker did in this tick from its tally, and publish
+        // it with the engine's own timings for readers on other threads.
+        //
+        void PublishTelemetry(high_resolution_clock::time_point tickStartTime, high_resolution_clock::time_point workersDoneTime, nanoseconds partitionTime)
+        {
+            TickTelemetry tick {};
+            tick.Tick = context_.Iterations;
+            tick.TotalWork = context_.TotalWork;
+            tick.PartitionNanoseconds = partitionTime.count();
+            tick.ItemsEmitted = context_.ExternalWorkSource.Tally.ItemsEmitted;
+
+            unsigned long long int slowestProcess { 0ULL };
+            unsigned long long int totalProcess { 0ULL };
+            for (auto index = 0ULL; index < context_.Workers.size(); index++)
+            {
+                auto& tally = context_.Workers[index]->GetContext().Tally;
+                auto& worker = context_.WorkerTicks[index];
+                worker.ItemsProcessed = tally.ItemsProcessed;
+                worker.ItemsEmitted = tally.ItemsEmitted;
+                worker.ProcessNanoseconds = ElapsedNanoseconds(tally.WakeTime, tally.ProcessEndTime);
+                worker.WaitNanoseconds = ElapsedNanoseconds(tally.FinishTime, workersDoneTime);
+                worker.WakeNanoseconds = ElapsedNanoseconds(tally.SignalTime, tally.WakeTime);
+
+                tick.ItemsProcessed += worker.ItemsProcessed;
+                tick.ItemsEmitted += worker.ItemsEmitted;
+                slowestProcess = std::max(slowestProcess, worker.ProcessNanoseconds);
+                totalProcess += worker.ProcessNanoseconds;
+            }
+
+            if (totalProcess > 0)
+                tick.LoadImbalance = static_cast<double>(slowestProcess) * context_.Workers.size() / static_cast<double>(totalProcess);
+            tick.TickNanoseconds = ElapsedNanoseconds(tickStartTime, high_resolution_clock::now());
+
+            context_.Telemetry.Publish(tick, context_.WorkerTicks.data(), context_.WorkerTicks.size());
+        }
+
+        static unsigned long long int ElapsedNanoseconds(high_resolution_clock::time_point start, high_resolution_clock::time_point end)
+        {
+            return end > start ? static_cast<unsigned long long int>(duration_cast<nanoseconds>(end - start).count()) : 0ULL;
+        }
+
+        void CheckpointIfDue()
+        {
+            if (context_.CheckpointInterval == 0 || context_.CheckpointFile.empty()) return;
+            if (context_.Iterations % context_.CheckpointInterval != 0) return;
+
+            if (!contextOp_.WriteCheckpoint())
+                cout << "ModelEngine could not write checkpoint " << context_.CheckpointFile << " at tick " << context_.Iterations << '\n';
+        }
+
+        void ReportPlacement()
+        {
+            cout << "ModelEngine running " << context_.WorkerCount << " workers on " << context_.PlacementCpus.size() << " usable cpus [ ";
+            for (auto cpu : context_.PlacementCpus)
+                cout << cpu << ' ';
+            cout << "]" << (context_.SkipSmtSiblings ? " without SMT siblings" : "");
+
+            if (!context_.PinThreads)
+            {
+                cout << ", not pinned\n";
+                return;
+            }
+
+            cout << ", engine on cpu " << CpuPlacement::CpuForThread(context_.PlacementCpus, 0) << ", workers on cpus [ ";
+            for (auto& worker : context_.Workers)
+                cout << worker->GetContext().Cpu << ' ';
+            cout << "]\n";
         }
 
         bool WaitForWorkOrQuit()
         {
-            if (waiter_) return waiter_->WaitForWorkOrQuit();
-            return true;
+            return waiter_.WaitForWorkOrQuit();
         }
 
         bool InitializeModel()
@@ -228,17 +433,17 @@ namespace embeddedpenguins::modelengine
 
                 if (workPresent)
                 {
-                    context_.Logger.Logger() << "Starting worker threads [ ";
+                    std::ostringstream workers;
                     for (auto& worker : context_.Workers)
                     {
                         auto& workForThread = worker->GetContext().WorkForThread;
                         if (workForThread.size() < 2)
                         {
-                            context_.Logger.Logger() << workForThread.size() << ' ';
+                            workers << workForThread.size() << ' ';
                         }
                         else
                         {
-                            context_.Logger.Logger() << workForThread.size() 
+                            workers << workForThread.size() 
                                 << '(' 
                                 << workForThread.front().Operator.Index
                                 << '-'
@@ -246,14 +451,12 @@ namespace embeddedpenguins::modelengine
                                 << ") ";
                         }
                     }
-                    context_.Logger.Logger() << "] for tick " << context_.Iterations << '\n';
-                    context_.Logger.Logit();
+                    context_.Logger.Write("Starting worker threads [ {}] for tick {}\n", workers.str(), context_.Iterations);
                 }
             }
             else if (context_.LoggingLevel != LogLevel::None)
             {
-                context_.Logger.Logger() << "Starting worker threads\n";
-                context_.Logger.Logit();
+                context_.Logger.Write("Starting worker threads\n");
             }
 #endif
 
@@ -267,21 +470,33 @@ namespace embeddedpenguins::modelengine
                 worker->WaitForPreviousScan();
 
 #ifndef NOLOG
-            context_.Logger.Logger() << "Worker threads complete\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("Worker threads complete\n");
 #endif
         }
 
-        void PartitionWork()
+        nanoseconds PartitionWork()
         {
             auto partitionStartTime = high_resolution_clock::now();
 
-            auto workForTick = partitioner_->SingleThreadPartitionStep();
-            if (workForTick > 0)
+            auto workForTick = partitioner_.SingleThreadPartitionStep();
+            if (context_.StopWhenIdle)
+                context_.PendingWork = workForTick + partitioner_.BacklogSize() + contextOp_.UnscheduledFutureWork();
+
+            if (context_.Waiting == WaitPolicy::FirstWork)
             {
-                auto partitionElapsed = high_resolution_clock::now() - partitionStartTime;
-                context_.PartitionTime += duration_cast<microseconds>(partitionElapsed);
+                // Future work scheduled for tick T is split out in tick T, to be done in tick T+1.
+                context_.NextScheduledTick = context_.Iterations + 1;
+                if (workForTick == 0)
+                    context_.NextScheduledTick = std::max(
+                        context_.NextScheduledTick, 
+                        std::min(partitioner_.NextScheduledTick(), contextOp_.EarliestUnscheduledFutureTick()));
             }
+
+            auto partitionElapsed = high_resolution_clock::now() - partitionStartTime;
+            if (workForTick > 0)
+                context_.PartitionTime += duration_cast<microseconds>(partitionElapsed);
+
+            return duration_cast<nanoseconds>(partitionElapsed);
         }
 
         void SwitchWorkingBuffersForAllWorkers()
@@ -303,14 +518,14 @@ namespace embeddedpenguins::modelengine
         void Cleanup()
         {
 #ifndef NOLOG
-            context_.Logger.Logger() << "ModelEngine waiting for worker threads to quit\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("ModelEngine waiting for worker threads to quit\n");
 #endif
             for (auto& worker : context_.Workers)
                 worker->Join();
+            contextOp_.FinishBackgroundCheckpoint();
+            contextOp_.JoinCompaction();
 #ifndef NOLOG
-            context_.Logger.Logger() << "ModelEngine joined all worker threads\n";
-            context_.Logger.Logit();
+            context_.Logger.Write("ModelEngine joined all worker threads\n");
 #endif
         }
    };
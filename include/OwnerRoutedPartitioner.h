@@ -0,0 +1,206 @@
+#pragma once
+
+#include <vector>
+
+#include "IModelEnginePartitioner.h"
+#include "IModelEngineBacklog.h"
+#include "ModelEngineCommon.h"
+#include "ModelEngineContext.h"
+#include "WorkerContextOp.h"
+#include "Worker.h"
+#include "WorkItem.h"
+#include "TimingWheel.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+    using std::begin;
+    using std::end;
+    using embeddedpenguins::modelengine::threads::Worker;
+    using embeddedpenguins::modelengine::threads::WorkerContextOp;
+    using embeddedpenguins::modelengine::threads::CurrentBufferType;
+
+    //
+    // OwnerRoutedPartitioner.  Each worker owns a fixed stripe of the model, as
+    // with the ConstantWidthPartitioner.  Workers (and the external work source)
+    // emit next-tick work directly into one outbox per owning worker, so
+    // the input for each worker next tick is just the concatenation of its inbound
+    // outboxes, plus any future work that has come due in its stripe.
+    // There is no global sort: work arrives grouped by owner, but not ordered
+    // by index within a stripe.
+    //
+    template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
+    class OwnerRoutedPartitioner : public IModelEnginePartitioner, public IModelEngineBacklog<OPERATORTYPE>
+    {
+        // Expose some internal state to derived classes to allow for testing.
+    protected:
+        ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context_;
+        TimingWheel<OPERATORTYPE> futureWork_ {};
+        vector<WorkItem<OPERATORTYPE>> dueWork_ {};
+        vector<vector<WorkItem<OPERATORTYPE>>> dueWorkByOwner_ {};
+        vector<vector<WorkItem<OPERATORTYPE>>> workForWorkers_ {};
+
+    public:
+        OwnerRoutedPartitioner(ModelEngineContext<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>& context) :
+            context_(context)
+        {
+            context_.Backlog = this;
+        }
+
+        //
+        // While the workers run, schedule the future work they created last tick,
+        // and route any future work due next tick to its owner.
+        //
+        virtual void ConcurrentPartitionStep() override
+        {
+#ifndef NOLOG
+            context_.Logger.Write("Tick {}: Scheduling future work from all workers and routing due work to owners\n", context_.Iterations);
+#endif
+
+            AccumulateFutureWorkFromAllWorkers();
+            RouteDueWorkToOwners();
+        }
+
+        //
+        // After the worker threads are done, gather each worker's inbound outboxes
+        // into its work for the next tick.
+        //
+        virtual unsigned long int SingleThreadPartitionStep() override
+        {
+#ifndef NOLOG
+            context_.Logger.Write("Tick {}: Gathering routed work for all workers\n", context_.Iterations);
+#endif
+
+            return GatherWorkForNextTickToAllWorkers();
+        }
+
+        virtual unsigned long long int BacklogSize() override
+        {
+            return futureWork_.Size();
+        }
+
+        virtual unsigned long long int NextScheduledTick() override
+        {
+            return futureWork_.EarliestTick();
+        }
+
+        virtual void ExportBacklog(vector<WorkItem<OPERATORTYPE>>& backlog) override
+        {
+            futureWork_.CopyTo(backlog);
+        }
+
+        virtual void ImportPendingWork(const vector<WorkItem<OPERATORTYPE>>& workForTick, const vector<WorkItem<OPERATORTYPE>>& backlog) override
+        {
+            futureWork_.StartAt(context_.Iterations);
+            for (auto& work : backlog)
+                futureWork_.Insert(work);
+
+            dueWorkByOwner_.resize(context_.Workers.size());
+            RouteToOwners(workForTick);
+            GatherWorkForNextTickToAllWorkers();
+        }
+
+    protected:
+        //
+        // Schedule all future work from all worker threads, as it was created in the previous tick.
+        // In the current tick, the worker threads are using the current buffer,
+        // so the other buffer is free for us to access read/write.
+        // NOTE: This may run concurrently with the worker threads.
+        //
+        void AccumulateFutureWorkFromAllWorkers()
+        {
+            for (auto& sourceWorker : context_.Workers)
+            {
+                auto& sourceWork =
+                    (sourceWorker->GetContext().CurrentBuffer == CurrentBufferType::Buffer2Current) ?
+                        sourceWorker->GetContext().WorkForFutureTicks1 :
+                        sourceWorker->GetContext().WorkForFutureTicks2;
+                for (auto& work : sourceWork)
+                    futureWork_.Insert(work);
+                sourceWork.clear();
+            }
+
+            auto& externalSourceWork =
+                (context_.ExternalWorkSource.CurrentBuffer == CurrentBufferType::Buffer2Current) ?
+                    context_.ExternalWorkSource.WorkForFutureTicks1 :
+                    context_.ExternalWorkSource.WorkForFutureTicks2;
+            for (auto& work : externalSourceWork)
+                futureWork_.Insert(work);
+            externalSourceWork.clear();
+        }
+
+        //
+        // Pull the work due next tick out of the timing wheel, and route it to the
+        // owner of each index.
+        // NOTE: This may run concurrently with the worker threads.
+        //
+        void RouteDueWorkToOwners()
+        {
+            dueWorkByOwner_.resize(context_.Workers.size());
+
+            dueWork_.clear();
+            futureWork_.ExtractDueWork(context_.Iterations + 1, dueWork_);
+            if (dueWork_.empty()) return;
+
+            RouteToOwners(dueWork_);
+        }
+
+        void RouteToOwners(const vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            auto stripeWidth = context_.Workers.front()->GetContext().RangeEnd - context_.Workers.front()->GetContext().RangeBegin;
+            if (stripeWidth == 0) stripeWidth = 1;
+
+            for (auto& workItem : work)
+            {
+                auto owner = static_cast<unsigned long long int>(workItem.Operator.Index) / stripeWidth;
+                if (owner >= dueWorkByOwner_.size()) owner = dueWorkByOwner_.size() - 1;
+                dueWorkByOwner_[owner].push_back(workItem);
+            }
+        }
+
+        //
+        // Each worker's work for the next tick is the future work due in its stripe,
+        // followed by the contents of its outbox in every source, in source order.
+        // The worker processes it in place, in a buffer owned by this partitioner.
+        // NOTE: This MUST NOT run concurrently with the worker threads.
+        //
+        unsigned long int GatherWorkForNextTickToAllWorkers()
+        {
+            unsigned long int totalWork { 0UL };
+            workForWorkers_.resize(context_.Workers.size());
+
+            for (auto owner = 0ULL; owner < context_.Workers.size(); owner++)
+            {
+                auto& workForThread = workForWorkers_[owner];
+                workForThread.clear();
+
+                if (owner < dueWorkByOwner_.size())
+                {
+                    auto& dueWork = dueWorkByOwner_[owner];
+                    workForThread.insert(end(workForThread), begin(dueWork), end(dueWork));
+                    dueWork.clear();
+                }
+
+                for (auto& sourceWorker : context_.Workers)
+                    GatherOutbox(sourceWorker->GetContext(), owner, workForThread);
+                GatherOutbox(context_.ExternalWorkSource, owner, workForThread);
+
+                context_.Workers[owner]->GetContext().WorkForThread.Assign(workForThread);
+                totalWork += workForThread.size();
+            }
+
+            context_.TotalWork += totalWork;
+            return totalWork;
+        }
+
+    private:
+        void GatherOutbox(WorkerContext<OPERATORTYPE, RECORDTYPE>& source, unsigned long long int owner, vector<WorkItem<OPERATORTYPE>>& workForThread)
+        {
+            if (owner >= source.WorkForTick1ByOwner.size()) return;
+
+            auto& outbox = source.WorkForTick1ByOwner[owner];
+            workForThread.insert(end(workForThread), begin(outbox), end(outbox));
+            outbox.clear();
+        }
+    };
+}
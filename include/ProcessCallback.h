@@ -40,11 +40,23 @@ namespace embeddedpenguins::modelengine::threads
         // to the current tick (this is typically called by work in progress),
         // so zero is invalid -- it is not possible to schedule any work for 
         // the current tick.  Treat anything less than 1 as 1.
+        // When the context has an outbox per owning worker, next-tick work
+        // goes straight to the outbox of the worker whose stripe holds its index.
         //
         void operator() (const OPERATORTYPE& work, int tickDelay = 1)
         {
+            ++context_.Tally.ItemsEmitted;
+
             if (tickDelay <= 1)
             {
+                if (!context_.WorkForTick1ByOwner.empty())
+                {
+                    auto owner = static_cast<unsigned long long int>(work.Index) / context_.OwnerStripeWidth;
+                    if (owner >= context_.WorkForTick1ByOwner.size()) owner = context_.WorkForTick1ByOwner.size() - 1;
+                    context_.WorkForTick1ByOwner[owner].push_back(WorkItem<OPERATORTYPE> { context_.Iterations + 1, work });
+                    return;
+                }
+
                 context_.WorkForTick1.push_back(WorkItem<OPERATORTYPE> { context_.Iterations + 1, work });
                 return;
             }
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+
+namespace embeddedpenguins::modelengine::threads
+{
+    using std::vector;
+    using std::unique_ptr;
+    using std::size_t;
+
+    constexpr size_t DefaultScratchArenaBytes { 1024 * 1024 };
+
+    //
+    // A bump allocator for scratch memory that only lives for one tick.
+    // Allocation just advances an offset into the current block, and
+    // nothing is freed until Reset() at the tick boundary rewinds the arena.
+    // If a tick needed more than one block, Reset() replaces them all with a
+    // single block large enough for that tick, so steady-state ticks make
+    // no heap allocations at all.
+    // Copying an arena gives a new, empty arena.
+    //
+    class ScratchArena
+    {
+        vector<unique_ptr<unsigned char[]>> blocks_ {};
+        vector<size_t> blockSizes_ {};
+        size_t offset_ { 0 };
+        size_t firstBlockSize_ { DefaultScratchArenaBytes };
+
+    public:
+        ScratchArena() = default;
+        explicit ScratchArena(size_t firstBlockSize) : firstBlockSize_(firstBlockSize) { }
+        ScratchArena(const ScratchArena& other) : firstBlockSize_(other.firstBlockSize_) { }
+        ScratchArena& operator=(const ScratchArena& other) { firstBlockSize_ = other.firstBlockSize_; return *this; }
+        ScratchArena(ScratchArena&&) = default;
+        ScratchArena& operator=(ScratchArena&&) = default;
+
+        const size_t BlockCount() const { return blocks_.size(); }
+        const size_t Capacity() const
+        {
+            size_t capacity { 0 };
+            for (auto blockSize : blockSizes_) capacity += blockSize;
+            return capacity;
+        }
+
+        void* Allocate(size_t bytes, size_t alignment)
+        {
+            if (!blocks_.empty())
+            {
+                auto* block = blocks_.back().get();
+                auto alignedOffset = AlignedOffset(block, offset_, alignment);
+                if (alignedOffset + bytes <= blockSizes_.back())
+                {
+                    offset_ = alignedOffset + bytes;
+                    return block + alignedOffset;
+                }
+            }
+
+            auto blockSize = blocks_.empty() ? firstBlockSize_ : blockSizes_.back() * 2;
+            if (blockSize < bytes + alignment) blockSize = bytes + alignment;
+            AddBlock(blockSize);
+
+            auto* block = blocks_.back().get();
+            auto alignedOffset = AlignedOffset(block, 0, alignment);
+            offset_ = alignedOffset + bytes;
+            return block + alignedOffset;
+        }
+
+        //
+        // Release everything allocated since the last reset.
+        //
+        void Reset()
+        {
+            if (blocks_.size() > 1)
+            {
+                auto capacity = Capacity();
+                blocks_.clear();
+                blockSizes_.clear();
+                AddBlock(capacity);
+            }
+
+            offset_ = 0;
+        }
+
+    private:
+        void AddBlock(size_t blockSize)
+        {
+            blocks_.push_back(unique_ptr<unsigned char[]>(new unsigned char[blockSize]));
+            blockSizes_.push_back(blockSize);
+        }
+
+        static size_t AlignedOffset(unsigned char* block, size_t offset, size_t alignment)
+        {
+            auto address = reinterpret_cast<size_t>(block + offset);
+            auto padding = (alignment - (address % alignment)) % alignment;
+            return offset + padding;
+        }
+    };
+
+    //
+    // A standard allocator drawing from a scratch arena, so that standard
+    // containers can be used for per-tick scratch work.  Deallocation does
+    // nothing; the memory is reclaimed when the arena is reset.
+    //
+    template<class T>
+    class ArenaAllocator
+    {
+        template<class U> friend class ArenaAllocator;
+
+        ScratchArena* arena_;
+
+    public:
+        using value_type = T;
+
+        explicit ArenaAllocator(ScratchArena& arena) noexcept : arena_(&arena) { }
+
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) { }
+
+        T* allocate(size_t count)
+        {
+            return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T*, size_t) noexcept { }
+
+        template<class U>
+        bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena_; }
+
+        template<class U>
+        bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena_; }
+    };
+}
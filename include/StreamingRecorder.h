@@ -0,0 +1,416 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <tuple>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <utility>
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "BinaryRecordFormat.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::string;
+    using std::vector;
+    using std::deque;
+    using std::tuple;
+    using std::atomic;
+    using std::mutex;
+    using std::lock_guard;
+    using std::unique_lock;
+    using std::thread;
+    using std::condition_variable;
+
+    constexpr unsigned long long int DefaultRecordBlockRecords { 4096ULL };
+    constexpr unsigned long long int DefaultRecordRingRecords { 65536ULL };
+    constexpr unsigned long long int RecordWriteBatchBytes { 1024ULL * 1024ULL };
+
+    //
+    // A block of records, each with the tick it was recorded in.
+    // A block is busy from the time it is handed to the writer until
+    // the writer has formatted every record in it.
+    //
+    template<class RECORDTYPE>
+    struct RecordBlock
+    {
+        vector<tuple<unsigned long long int, RECORDTYPE>> Records {};
+        atomic<bool> Busy { false };
+    };
+
+    //
+    // Drain blocks of records to a file on a thread of its own, while
+    // the model runs.  Records are formatted on this thread, gathered into
+    // large batches, and written with pwrite(), so neither the workers nor
+    // the disk wait on each other record by record.
+    // Records are written as CSV rows, or in the binary record format if
+    // asked for and the record type supports it.
+    // Blocks from different recorders are written in the order they fill,
+    // so rows of different threads are interleaved block by block; every
+    // row starts with its tick.
+    //
+    template<class RECORDTYPE>
+    class RecordWriter
+    {
+        string path_ {};
+        RecordFormat format_ { RecordFormat::Csv };
+        int fileDescriptor_ { -1 };
+        off_t offset_ { 0 };
+        string batch_ {};
+        unsigned long long int recordsWritten_ { 0ULL };
+        bool failed_ { false };
+
+        mutex mutex_ {};
+        condition_variable cv_ {};
+        deque<RecordBlock<RECORDTYPE>*> queue_ {};
+        bool stop_ { false };
+        thread thread_ {};
+
+    public:
+        RecordWriter() = default;
+        RecordWriter(const RecordWriter&) = delete;
+        RecordWriter& operator=(const RecordWriter&) = delete;
+
+        ~RecordWriter()
+        {
+            Close();
+        }
+
+        const string& Path() const { return path_; }
+        const RecordFormat Format() const { return format_; }
+        const bool IsOpen() const { return fileDescriptor_ >= 0; }
+        const unsigned long long int RecordsWritten() const { return recordsWritten_; }
+        const bool Failed() const { return failed_; }
+
+        //
+        // Create the record file with its header, and start draining.
+        // A binary record file takes the .rec extension in place of .csv.
+        //
+        bool Open(const string& path, RecordFormat format = RecordFormat::Csv)
+        {
+            if (IsOpen()) return false;
+
+            format_ = (format == RecordFormat::Binary && HasRecordColumns<RECORDTYPE>::value) ? RecordFormat::Binary : RecordFormat::Csv;
+            path_ = (format_ == RecordFormat::Binary) ? BinaryRecordPath(path) : path;
+            fileDescriptor_ = open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fileDescriptor_ < 0) return false;
+
+            offset_ = 0;
+            batch_.clear();
+            batch_.reserve(RecordWriteBatchBytes * 2);
+            if constexpr (HasRecordColumns<RECORDTYPE>::value)
+                if (format_ == RecordFormat::Binary) BinaryRecordFormat<RECORDTYPE>::EncodeFileHeader(batch_);
+            if (format_ == RecordFormat::Csv)
+                batch_ = "Tick," + RECORDTYPE::Header() + '\n';
+            stop_ = false;
+            thread_ = thread([this]() { Drain(); });
+
+            return true;
+        }
+
+        //
+        // Queue a full block.  The block stays busy until it has been formatted.
+        //
+        void Submit(RecordBlock<RECORDTYPE>& block)
+        {
+            block.Busy.store(true, std::memory_order_relaxed);
+            {
+                lock_guard<mutex> lock(mutex_);
+                queue_.push_back(&block);
+            }
+            cv_.notify_one();
+        }
+
+        //
+        // Write out every queued block, then stop and close the file.
+        //
+        void Close()
+        {
+            if (!thread_.joinable()) return;
+
+            {
+                lock_guard<mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_one();
+            thread_.join();
+
+            close(fileDescriptor_);
+            fileDescriptor_ = -1;
+        }
+
+    private:
+        void Drain()
+        {
+            while (true)
+            {
+                RecordBlock<RECORDTYPE>* block { nullptr };
+                bool more { false };
+                {
+                    unique_lock<mutex> lock(mutex_);
+                    cv_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+                    if (queue_.empty()) break;
+
+                    block = queue_.front();
+                    queue_.pop_front();
+                    more = !queue_.empty();
+                }
+
+                Encode(block->Records);
+                recordsWritten_ += block->Records.size();
+
+                // The records are copied out, so the recorder may refill the block.
+                block->Records.clear();
+                block->Busy.store(false, std::memory_order_release);
+
+                if (!more || batch_.size() >= RecordWriteBatchBytes)
+                    WriteBatch();
+            }
+
+            WriteBatch();
+        }
+
+        void Encode(vector<tuple<unsigned long long int, RECORDTYPE>>& records)
+        {
+            if constexpr (HasRecordColumns<RECORDTYPE>::value)
+            {
+                if (format_ == RecordFormat::Binary)
+                {
+                    BinaryRecordFormat<RECORDTYPE>::EncodeBlock(records, batch_);
+                    return;
+                }
+            }
+
+            for (auto& [tick, record] : records)
+            {
+                batch_ += std::to_string(tick);
+                batch_ += ',';
+                batch_ += record.Format();
+                batch_ += '\n';
+            }
+        }
+
+        void WriteBatch()
+        {
+            auto* data = batch_.data();
+            auto remaining = batch_.size();
+            while (remaining > 0 && !failed_)
+            {
+                auto written = pwrite(fileDescriptor_, data, remaining, offset_);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    failed_ = true;
+                    break;
+                }
+
+                data += written;
+                remaining -= written;
+                offset_ += written;
+            }
+
+            batch_.clear();
+        }
+    };
+
+    enum class RecordMode
+    {
+        Stream,
+        Ring
+    };
+
+    //
+    // How a recorder keeps its records.  In stream mode every record goes
+    // to the writer; in ring mode only the most recent records are kept in
+    // a fixed ring, and written when dumped.  In either mode, records may
+    // be sampled to every Nth tick, and to the subset of node indexes whose
+    // hash falls in one bucket out of IndexSample.
+    //
+    struct RecordSettings
+    {
+        RecordMode Mode { RecordMode::Stream };
+        unsigned long long int BlockRecords { DefaultRecordBlockRecords };
+        unsigned long long int RingRecords { DefaultRecordRingRecords };
+        unsigned long long int RingTicks { 0ULL };
+        unsigned long long int EveryTicks { 1ULL };
+        unsigned long long int IndexSample { 1ULL };
+    };
+
+    //
+    // Record into a pair of blocks, so one block may fill while the other
+    // is written out by a RecordWriter.  A full block is handed to the writer,
+    // and recording carries on in the other block, first waiting for the
+    // writer to finish with it if the writer has fallen behind.  Memory use
+    // is bounded by the two blocks.
+    // As a flight recorder, records go instead into a ring of fixed size,
+    // overwriting the oldest, and only the last RingTicks ticks of them are
+    // written when dumped.
+    // All storage is reserved when a writer is attached, so recording a
+    // record of a trivially copyable type never allocates.
+    // Until a writer is attached, records accumulate in the first block;
+    // if it fills first, its records are dropped, so a recorder that never
+    // gets a writer is bounded too.
+    // Each recorder must only be used from one thread at a time.
+    //
+    template<class RECORDTYPE>
+    class StreamingRecorder
+    {
+        unsigned long long int& ticks_;
+        RecordBlock<RECORDTYPE> blocks_[2] {};
+        int filling_ { 0 };
+        RecordSettings settings_ {};
+        RecordWriter<RECORDTYPE>* writer_ { nullptr };
+        vector<tuple<unsigned long long int, RECORDTYPE>> ring_ {};
+        unsigned long long int ringNext_ { 0ULL };
+
+    public:
+        StreamingRecorder(unsigned long long int& ticks) :
+            ticks_(ticks)
+        {
+        }
+
+        StreamingRecorder(const StreamingRecorder&) = delete;
+        StreamingRecorder& operator=(const StreamingRecorder&) = delete;
+
+        const RecordSettings& Settings() const { return settings_; }
+
+        //
+        // Whether a record for this node would be kept in the current tick.
+        // Implementations may check this to skip building records that would be dropped.
+        //
+        bool Samples(unsigned long long int index) const
+        {
+            if (settings_.EveryTicks > 1 && ticks_ % settings_.EveryTicks != 0) return false;
+            return settings_.IndexSample <= 1 || IndexHash(index) % settings_.IndexSample == 0;
+        }
+
+        void Record(RECORDTYPE record)
+        {
+            if (settings_.EveryTicks > 1 && ticks_ % settings_.EveryTicks != 0) return;
+            if constexpr (HasRecordColumns<RECORDTYPE>::value)
+                if (settings_.IndexSample > 1 && IndexHash(static_cast<unsigned long long int>(record.*std::get<0>(RECORDTYPE::Columns()))) % settings_.IndexSample != 0) return;
+
+            if (settings_.Mode == RecordMode::Ring && writer_)
+            {
+                RecordToRing(std::move(record));
+                return;
+            }
+
+            auto& block = blocks_[filling_];
+            if (!writer_ && block.Records.size() >= settings_.BlockRecords)
+                block.Records.clear();
+
+            block.Records.emplace_back(ticks_, std::move(record));
+            if (writer_ && block.Records.size() >= settings_.BlockRecords)
+                HandOff();
+        }
+
+        void Attach(RecordWriter<RECORDTYPE>& writer, const RecordSettings& settings = RecordSettings {})
+        {
+            writer_ = &writer;
+            settings_ = settings;
+            if (settings_.BlockRecords == 0) settings_.BlockRecords = DefaultRecordBlockRecords;
+            if (settings_.RingRecords == 0) settings_.RingRecords = DefaultRecordRingRecords;
+            for (auto& block : blocks_)
+                block.Records.reserve(settings_.BlockRecords);
+            if (settings_.Mode == RecordMode::Ring)
+                ring_.reserve(settings_.RingRecords);
+        }
+
+        void Attach(RecordWriter<RECORDTYPE>& writer, unsigned long long int blockRecords)
+        {
+            RecordSettings settings {};
+            settings.BlockRecords = blockRecords;
+            Attach(writer, settings);
+        }
+
+        //
+        // Hand the records of the last RingTicks ticks in the ring to the
+        // writer, oldest first, and empty the ring.
+        //
+        void Dump()
+        {
+            if (!writer_ || ring_.empty()) return;
+
+            auto firstTick = (settings_.RingTicks > 0 && ticks_ >= settings_.RingTicks) ? ticks_ - settings_.RingTicks + 1 : 0ULL;
+            auto oldest = (ring_.size() < settings_.RingRecords) ? 0ULL : ringNext_;
+            for (auto entry = 0ULL; entry < ring_.size(); entry++)
+            {
+                auto& record = ring_[(oldest + entry) % ring_.size()];
+                if (std::get<0>(record) < firstTick) continue;
+
+                auto& block = blocks_[filling_];
+                block.Records.push_back(record);
+                if (block.Records.size() >= settings_.BlockRecords)
+                    HandOff();
+            }
+
+            ring_.clear();
+            ringNext_ = 0ULL;
+        }
+
+        //
+        // Hand the partly filled block to the writer, and wait until the
+        // writer is done with both blocks.  A ring is dumped first.
+        // Without a writer, the records are dropped.
+        //
+        void Flush()
+        {
+            if (!writer_)
+            {
+                blocks_[filling_].Records.clear();
+                return;
+            }
+
+            Dump();
+            if (!blocks_[filling_].Records.empty())
+                HandOff();
+
+            for (auto& block : blocks_)
+                while (block.Busy.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+        }
+
+    private:
+        void RecordToRing(RECORDTYPE&& record)
+        {
+            if (ring_.size() < settings_.RingRecords)
+            {
+                ring_.emplace_back(ticks_, std::move(record));
+                return;
+            }
+
+            ring_[ringNext_] = std::make_tuple(ticks_, std::move(record));
+            ringNext_ = (ringNext_ + 1) % ring_.size();
+        }
+
+        void HandOff()
+        {
+            writer_->Submit(blocks_[filling_]);
+            filling_ = 1 - filling_;
+
+            auto& next = blocks_[filling_];
+            while (next.Busy.load(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+
+        //
+        // Mix the index, so a sampled subset is spread over the whole model
+        // rather than falling on a stride.
+        //
+        static unsigned long long int IndexHash(unsigned long long int index)
+        {
+            index += 0x9e3779b97f4a7c15ULL;
+            index = (index ^ (index >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            index = (index ^ (index >> 27)) * 0x94d049bb133111ebULL;
+            return index ^ (index >> 31);
+        }
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <climits>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+namespace embeddedpenguins::modelengine::threads
+{
+    using std::atomic;
+    using std::memory_order_relaxed;
+    using std::memory_order_acquire;
+    using std::memory_order_acq_rel;
+    using std::memory_order_seq_cst;
+
+    constexpr unsigned int DefaultBarrierSpinCount { 10'000 };
+    constexpr unsigned int BarrierSpinsPerYield { 64 };
+
+    //
+    // A reusable sense-reversing barrier for a fixed number of participants.
+    // Each participant keeps its own local sense, which flips on each passage.
+    // The last participant to arrive resets the count and publishes the new
+    // sense; the others spin on the shared sense for a configurable budget,
+    // then park on a futex until it changes.  The releaser only makes the
+    // wake system call when someone has actually parked.  Spinners yield
+    // periodically, so an oversubscribed machine still makes progress.
+    // The counter, the sense and the parked count each live on their own
+    // cache line, so spinning participants do not contend with arrivals.
+    //
+    class TickBarrier
+    {
+        static constexpr unsigned int CacheLineSize { 64 };
+
+        alignas(CacheLineSize) atomic<int> remaining_;
+        alignas(CacheLineSize) atomic<int> sense_ { 0 };
+        alignas(CacheLineSize) atomic<int> parked_ { 0 };
+        const int participants_;
+        const unsigned int spinCount_;
+
+    public:
+        TickBarrier(int participants, unsigned int spinCount = DefaultBarrierSpinCount) :
+            remaining_(participants),
+            participants_(participants),
+            spinCount_(spinCount)
+        {
+        }
+
+        TickBarrier(const TickBarrier&) = delete;
+        TickBarrier& operator=(const TickBarrier&) = delete;
+
+        //
+        // Arrive at the barrier, and return when all participants have arrived.
+        // The local sense must start at zero and be used only by the calling
+        // participant, for this barrier.
+        //
+        void ArriveAndWait(int& localSense)
+        {
+            localSense = 1 - localSense;
+
+            if (remaining_.fetch_sub(1, memory_order_acq_rel) == 1)
+            {
+                remaining_.store(participants_, memory_order_relaxed);
+                sense_.store(localSense, memory_order_seq_cst);
+                if (parked_.load(memory_order_seq_cst) > 0)
+                    FutexWakeAll();
+
+                return;
+            }
+
+            for (auto spin = spinCount_; spin; spin--)
+            {
+                if (sense_.load(memory_order_acquire) == localSense) return;
+                if (spin % BarrierSpinsPerYield == 0)
+                    std::this_thread::yield();
+                else
+                    CpuRelax();
+            }
+
+            parked_.fetch_add(1, memory_order_seq_cst);
+            while (sense_.load(memory_order_seq_cst) != localSense)
+                FutexWait(1 - localSense);
+            parked_.fetch_sub(1, memory_order_relaxed);
+        }
+
+    private:
+        void FutexWait(int expected)
+        {
+            syscall(SYS_futex, reinterpret_cast<int*>(&sense_), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+        }
+
+        void FutexWakeAll()
+        {
+            syscall(SYS_futex, reinterpret_cast<int*>(&sense_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        }
+
+        static void CpuRelax()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__)
+            asm volatile("yield");
+#endif
+        }
+    };
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <limits>
+
+#include "WorkItem.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+    using std::array;
+
+    //
+    // A hierarchical timing wheel holding work scheduled for future ticks.
+    // Each level is a ring of slots, where a slot at level N covers 256^N ticks.
+    // Work is placed at the lowest level whose span covers its distance from
+    // the current tick, and cascades down one level each time the wheel turns
+    // past the start of its slot.  Work too far in the future for the highest
+    // level waits in an overflow list until the top level wraps.
+    // Extracting the work due by a given tick costs only as much as the work
+    // that is actually due, plus the amortized cascades, rather than a scan
+    // of the whole backlog.
+    //
+    template<class OPERATORTYPE>
+    class TimingWheel
+    {
+        static constexpr unsigned int SlotBits { 8 };
+        static constexpr unsigned long long int SlotCount { 1ULL << SlotBits };
+        static constexpr unsigned long long int SlotMask { SlotCount - 1 };
+        static constexpr unsigned int LevelCount { 4 };
+
+        array<array<vector<WorkItem<OPERATORTYPE>>, SlotCount>, LevelCount> levels_ {};
+        vector<WorkItem<OPERATORTYPE>> overflow_ {};
+        unsigned long long int currentTick_ { 0ULL };
+        unsigned long long int size_ { 0ULL };
+
+    public:
+        const unsigned long long int Size() const { return size_; }
+        const bool Empty() const { return size_ == 0; }
+        const unsigned long long int CurrentTick() const { return currentTick_; }
+
+        //
+        // Schedule a work item by its Tick.  Work scheduled for a tick
+        // that has already been extracted will be returned with the
+        // next extraction.
+        //
+        void Insert(const WorkItem<OPERATORTYPE>& work)
+        {
+            ++size_;
+            Place(work);
+        }
+
+        //
+        // Turn an empty wheel directly to the given tick, as when
+        // scheduled work is restored part way through a run.
+        //
+        void StartAt(unsigned long long int tick)
+        {
+            if (size_ == 0) currentTick_ = tick;
+        }
+
+        //
+        // Append a copy of all scheduled work, in no particular order.
+        //
+        void CopyTo(vector<WorkItem<OPERATORTYPE>>& work) const
+        {
+            for (auto& level : levels_)
+                for (auto& slot : level)
+                    work.insert(std::end(work), std::begin(slot), std::end(slot));
+            work.insert(std::end(work), std::begin(overflow_), std::end(overflow_));
+        }
+
+        //
+        // Find the earliest tick of any scheduled work, or the maximum
+        // tick if nothing is scheduled.  Within each level, the first
+        // occupied slot after the current one holds that level's earliest work.
+        // Above level 0, the current slot can only hold work for the next
+        // rotation of that level, so it is looked at last.
+        //
+        unsigned long long int EarliestTick() const
+        {
+            auto earliestTick = std::numeric_limits<unsigned long long int>::max();
+            if (size_ == 0) return earliestTick;
+
+            for (auto level = 0U; level < LevelCount; level++)
+            {
+                auto currentSlot = (currentTick_ >> (SlotBits * level)) & SlotMask;
+                auto firstOffset = (level == 0) ? 0ULL : 1ULL;
+                for (auto step = 0ULL; step < SlotCount; step++)
+                {
+                    auto& slot = levels_[level][(currentSlot + firstOffset + step) & SlotMask];
+                    if (slot.empty()) continue;
+
+                    for (auto& work : slot)
+                        if (work.Tick < earliestTick) earliestTick = work.Tick;
+                    break;
+                }
+            }
+
+            for (auto& work : overflow_)
+                if (work.Tick < earliestTick) earliestTick = work.Tick;
+
+            return earliestTick;
+        }
+
+        //
+        // Move all work scheduled before the cutoff tick into the
+        // due work collection, and turn the wheel to the cutoff tick.
+        //
+        void ExtractDueWork(unsigned long long int cutoffTick, vector<WorkItem<OPERATORTYPE>>& dueWork)
+        {
+            if (size_ == 0)
+            {
+                // Nothing is scheduled, so the wheel may jump directly to the cutoff.
+                if (cutoffTick > currentTick_) currentTick_ = cutoffTick;
+                return;
+            }
+
+            while (currentTick_ < cutoffTick && size_ > 0)
+            {
+                if ((currentTick_ & SlotMask) == 0)
+                    Cascade(1);
+
+                auto& slot = levels_[0][currentTick_ & SlotMask];
+                if (!slot.empty())
+                {
+                    dueWork.insert(std::end(dueWork), std::begin(slot), std::end(slot));
+                    size_ -= slot.size();
+                    slot.clear();
+                }
+
+                ++currentTick_;
+            }
+
+            if (cutoffTick > currentTick_) currentTick_ = cutoffTick;
+        }
+
+    private:
+        void Place(const WorkItem<OPERATORTYPE>& work)
+        {
+            // Late work goes into the current slot, to be extracted next time.
+            if (work.Tick < currentTick_)
+            {
+                levels_[0][currentTick_ & SlotMask].push_back(work);
+                return;
+            }
+
+            auto delta = work.Tick - currentTick_;
+            for (auto level = 0U; level < LevelCount; level++)
+            {
+                if (delta < (1ULL << (SlotBits * (level + 1))))
+                {
+                    levels_[level][(work.Tick >> (SlotBits * level)) & SlotMask].push_back(work);
+                    return;
+                }
+            }
+
+            overflow_.push_back(work);
+        }
+
+        //
+        // The wheel has turned to the start of a slot at the given level.
+        // Redistribute the work in that slot to the lower levels, first
+        // cascading the level above if it has also turned.
+        //
+        void Cascade(unsigned int level)
+        {
+            if (level == LevelCount)
+            {
+                vector<WorkItem<OPERATORTYPE>> overflow {};
+                overflow.swap(overflow_);
+                for (auto& work : overflow)
+                    Place(work);
+
+                return;
+            }
+
+            auto slotIndex = (currentTick_ >> (SlotBits * level)) & SlotMask;
+            if (slotIndex == 0)
+                Cascade(level + 1);
+
+            auto& slot = levels_[level][slotIndex];
+            if (slot.empty()) return;
+
+            vector<WorkItem<OPERATORTYPE>> cascading {};
+            cascading.swap(slot);
+            for (auto& work : cascading)
+                Place(work);
+
+            // Keep the allocation for the next time this slot fills.
+            cascading.clear();
+            slot.swap(cascading);
+        }
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace embeddedpenguins::modelengine::threads
+{
+    using std::atomic;
+    using std::vector;
+    using std::pair;
+    using std::memory_order_relaxed;
+    using std::memory_order_acquire;
+    using std::memory_order_acq_rel;
+
+    constexpr unsigned int DefaultChunksPerWorker { 8 };
+
+    //
+    // The chunks of one worker's work for a tick, as [begin, end) offsets into
+    // that worker's WorkForThread.  The chunks are filled in between ticks by a
+    // single thread.  During the tick, the owning worker takes chunks from the
+    // front, and idle workers steal chunks from the back.  The head and tail
+    // are packed into one atomic word, so every take is a single compare-exchange
+    // and each chunk is handed to exactly one thread.
+    //
+    class WorkChunkQueue
+    {
+        using ChunkRange = pair<unsigned long long int, unsigned long long int>;
+
+        alignas(64) atomic<unsigned long long int> headAndTail_ { 0ULL };
+        vector<ChunkRange> chunks_ {};
+
+    public:
+        const unsigned long long int ChunkCount() const { return chunks_.size(); }
+        const ChunkRange& operator[](unsigned long long int chunk) const { return chunks_[chunk]; }
+
+        //
+        // Only call these while no worker thread is running.
+        //
+        void Clear()
+        {
+            chunks_.clear();
+            headAndTail_.store(0ULL, memory_order_relaxed);
+        }
+
+        void Add(unsigned long long int chunkBegin, unsigned long long int chunkEnd)
+        {
+            chunks_.push_back(ChunkRange { chunkBegin, chunkEnd });
+            headAndTail_.store(Pack(0, chunks_.size()), memory_order_relaxed);
+        }
+
+        //
+        // The owning worker takes the lowest remaining chunk.
+        //
+        bool TakeFront(unsigned long long int& chunk)
+        {
+            auto headAndTail = headAndTail_.load(memory_order_acquire);
+            do
+            {
+                if (Head(headAndTail) >= Tail(headAndTail)) return false;
+                chunk = Head(headAndTail);
+            }
+            while (!headAndTail_.compare_exchange_weak(headAndTail, Pack(chunk + 1, Tail(headAndTail)), memory_order_acq_rel, memory_order_acquire));
+
+            return true;
+        }
+
+        //
+        // Another worker steals the highest remaining chunk.
+        //
+        bool StealBack(unsigned long long int& chunk)
+        {
+            auto headAndTail = headAndTail_.load(memory_order_acquire);
+            do
+            {
+                if (Head(headAndTail) >= Tail(headAndTail)) return false;
+                chunk = Tail(headAndTail) - 1;
+            }
+            while (!headAndTail_.compare_exchange_weak(headAndTail, Pack(Head(headAndTail), chunk), memory_order_acq_rel, memory_order_acquire));
+
+            return true;
+        }
+
+    private:
+        static unsigned long long int Pack(unsigned long long int head, unsigned long long int tail) { return (tail << 32) | head; }
+        static unsigned long long int Head(unsigned long long int headAndTail) { return headAndTail & 0xFFFFFFFFULL; }
+        static unsigned long long int Tail(unsigned long long int headAndTail) { return headAndTail >> 32; }
+    };
+}
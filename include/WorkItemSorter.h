@@ -0,0 +1,229 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include "WorkItem.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+    using std::pair;
+
+    //
+    // An operation type opts in to having its work for the same index
+    // coalesced with a member
+    //     bool Combine(const OPERATORTYPE& other)
+    // which folds the other operation into this one and returns true,
+    // or returns false if the two must stay apart (for example, because
+    // they are different kinds of operation).
+    //
+    template<class OPERATORTYPE, class = void>
+    struct HasCombine : std::false_type { };
+
+    template<class OPERATORTYPE>
+    struct HasCombine<OPERATORTYPE, std::void_t<decltype(static_cast<bool>(std::declval<OPERATORTYPE&>().Combine(std::declval<const OPERATORTYPE&>())))>> : std::true_type { };
+
+    //
+    // Group work items by Operator.Index in linear time, using an LSD radix
+    // sort bounded by the known range of indexes (normally the model size).
+    // Only as many radix passes as the index range needs are made, and the
+    // sort is stable, so work for the same index keeps its original order.
+    // Runs that are already sorted may be merged with a k-way merge.
+    // Keep an instance alive across ticks so its scratch buffers are reused.
+    //
+    template<class OPERATORTYPE>
+    class WorkItemSorter
+    {
+        static constexpr unsigned int MaxDigitBits { 11 };
+        static constexpr unsigned int MaxPasses { 6 };
+
+        // Below this size a comparison sort is cheaper than clearing histograms.
+        static constexpr unsigned long long int MinimumRadixSize { 256 };
+
+        vector<WorkItem<OPERATORTYPE>> scratch_ {};
+        vector<unsigned long long int> histograms_ {};
+
+        // The run number and the position of the next item in that run.
+        using RunHead = pair<unsigned long long int, unsigned long long int>;
+        vector<RunHead> heads_ {};
+
+    public:
+        //
+        // Sort the work by index.  Every index is expected to be less than
+        // the index limit; if any is not, fall back to a comparison sort.
+        //
+        void SortByIndex(vector<WorkItem<OPERATORTYPE>>& work, unsigned long long int indexLimit)
+        {
+            if (work.size() < 2) return;
+            if (indexLimit == 0) indexLimit = 1;
+
+            unsigned int keyBits { 1 };
+            while (keyBits < 64 && (indexLimit - 1) >> keyBits) keyBits++;
+            auto passes = (keyBits + MaxDigitBits - 1) / MaxDigitBits;
+
+            if (work.size() < MinimumRadixSize || passes > MaxPasses || !CountDigits(work, indexLimit, keyBits, passes))
+            {
+                std::stable_sort(
+                    begin(work),
+                    end(work),
+                    [](const WorkItem<OPERATORTYPE>& lhs, const WorkItem<OPERATORTYPE>& rhs){
+                        return lhs.Operator.Index < rhs.Operator.Index;
+                });
+                return;
+            }
+
+            auto digitBits = (keyBits + passes - 1) / passes;
+            auto bucketCount = 1ULL << digitBits;
+            scratch_.resize(work.size());
+
+            auto* source = &work;
+            auto* target = &scratch_;
+            for (auto pass = 0U; pass < passes; pass++)
+            {
+                auto shift = pass * digitBits;
+                auto* offsets = &histograms_[pass * bucketCount];
+
+                // Skip passes where every item falls in the same bucket.
+                auto firstKey = (static_cast<unsigned long long int>(source->front().Operator.Index) >> shift) & (bucketCount - 1);
+                if (offsets[firstKey] == source->size()) continue;
+
+                unsigned long long int total { 0ULL };
+                for (auto bucket = 0ULL; bucket < bucketCount; bucket++)
+                {
+                    auto count = offsets[bucket];
+                    offsets[bucket] = total;
+                    total += count;
+                }
+
+                for (auto& item : *source)
+                {
+                    auto key = (static_cast<unsigned long long int>(item.Operator.Index) >> shift) & (bucketCount - 1);
+                    (*target)[offsets[key]++] = item;
+                }
+
+                std::swap(source, target);
+            }
+
+            if (source != &work)
+                work.swap(scratch_);
+        }
+
+        //
+        // Merge runs that are each already sorted by index into one collection
+        // sorted by index, using a heap of the run heads.  Work for the same index
+        // keeps the order of the runs it came from.  Consecutive items from one run
+        // are copied without touching the heap, so runs covering mostly separate
+        // index ranges merge in close to linear time.
+        //
+        void MergeRuns(const vector<vector<WorkItem<OPERATORTYPE>>*>& runs, vector<WorkItem<OPERATORTYPE>>& merged)
+        {
+            merged.clear();
+            heads_.clear();
+
+            unsigned long long int totalWork { 0ULL };
+            for (auto run = 0ULL; run < runs.size(); run++)
+            {
+                if (runs[run]->empty()) continue;
+
+                heads_.push_back(RunHead { run, 0ULL });
+                totalWork += runs[run]->size();
+            }
+            merged.reserve(totalWork);
+
+            auto after = [&runs](const RunHead& lhs, const RunHead& rhs)
+            {
+                auto lhsIndex = (*runs[lhs.first])[lhs.second].Operator.Index;
+                auto rhsIndex = (*runs[rhs.first])[rhs.second].Operator.Index;
+                return rhsIndex < lhsIndex || (lhsIndex == rhsIndex && rhs.first < lhs.first);
+            };
+
+            std::make_heap(begin(heads_), end(heads_), after);
+            while (!heads_.empty())
+            {
+                std::pop_heap(begin(heads_), end(heads_), after);
+                auto& head = heads_.back();
+                auto& run = *runs[head.first];
+
+                // Copy from this run until its next item comes after the lowest remaining head.
+                do
+                {
+                    merged.push_back(run[head.second++]);
+                }
+                while (head.second < run.size() && (heads_.size() == 1 || !after(head, heads_.front())));
+
+                if (head.second < run.size())
+                    std::push_heap(begin(heads_), end(heads_), after);
+                else
+                    heads_.pop_back();
+            }
+        }
+
+        //
+        // Combine work for the same index, for operation types with a Combine()
+        // member, so each index is processed at most once for each kind of
+        // operation.  Each item is folded into the first item kept for its
+        // index that accepts it, or kept if none does.  The work must already
+        // be grouped by index.  Return how many items were combined away.
+        //
+        unsigned long long int Coalesce(vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            if constexpr (!HasCombine<OPERATORTYPE>::value)
+            {
+                return 0ULL;
+            }
+            else
+            {
+                auto kept { 0ULL };
+                auto groupBegin { 0ULL };
+                for (auto item = 0ULL; item < work.size(); item++)
+                {
+                    if (groupBegin < kept && work[groupBegin].Operator.Index != work[item].Operator.Index)
+                        groupBegin = kept;
+
+                    auto combined { false };
+                    for (auto target = groupBegin; target < kept && !combined; target++)
+                        combined = work[target].Operator.Combine(work[item].Operator);
+
+                    if (!combined)
+                    {
+                        if (kept != item) work[kept] = work[item];
+                        kept++;
+                    }
+                }
+
+                auto removed = work.size() - kept;
+                work.erase(begin(work) + kept, end(work));
+                return removed;
+            }
+        }
+
+    private:
+        //
+        // Build the histograms for all passes in a single read of the work.
+        // Return false if any index is out of range.
+        //
+        bool CountDigits(const vector<WorkItem<OPERATORTYPE>>& work, unsigned long long int indexLimit, unsigned int keyBits, unsigned int passes)
+        {
+            auto digitBits = (keyBits + passes - 1) / passes;
+            auto bucketCount = 1ULL << digitBits;
+            auto digitMask = bucketCount - 1;
+
+            histograms_.assign(passes * bucketCount, 0ULL);
+            auto* histograms = histograms_.data();
+
+            for (auto& item : work)
+            {
+                auto index = static_cast<unsigned long long int>(item.Operator.Index);
+                if (index >= indexLimit) return false;
+
+                for (auto pass = 0U; pass < passes; pass++)
+                    histograms[pass * bucketCount + ((index >> (pass * digitBits)) & digitMask)]++;
+            }
+
+            return true;
+        }
+    };
+}
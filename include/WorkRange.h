@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+
+#include "WorkItem.h"
+
+namespace embeddedpenguins::modelengine
+{
+    using std::vector;
+
+    //
+    // A view of a contiguous range of work items owned by someone else,
+    // typically a buffer owned by the partitioner.  The owner guarantees the
+    // range stays valid for the tick it was handed off for, so workers can
+    // process it in place without copying.
+    //
+    template<class OPERATORTYPE>
+    class WorkRange
+    {
+    public:
+        using iterator = typename vector<WorkItem<OPERATORTYPE>>::iterator;
+
+    private:
+        iterator begin_ {};
+        iterator end_ {};
+
+    public:
+        WorkRange() = default;
+
+        WorkRange(iterator rangeBegin, iterator rangeEnd) :
+            begin_(rangeBegin),
+            end_(rangeEnd)
+        {
+        }
+
+        iterator begin() const { return begin_; }
+        iterator end() const { return end_; }
+        const unsigned long long int size() const { return end_ - begin_; }
+        const bool empty() const { return begin_ == end_; }
+        WorkItem<OPERATORTYPE>& operator[](unsigned long long int index) const { return *(begin_ + index); }
+        WorkItem<OPERATORTYPE>& front() const { return *begin_; }
+        WorkItem<OPERATORTYPE>& back() const { return *(end_ - 1); }
+
+        void Assign(iterator rangeBegin, iterator rangeEnd)
+        {
+            begin_ = rangeBegin;
+            end_ = rangeEnd;
+        }
+
+        void Assign(vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            Assign(work.begin(), work.end());
+        }
+
+        void clear()
+        {
+            begin_ = end_;
+        }
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <thread>
+#include <chrono>
 
 #include "ConfigurationRepository.h"
 
@@ -12,22 +13,23 @@
 namespace embeddedpenguins::modelengine::threads
 {
     using std::thread;
-    using std::unique_lock;
-    using std::lock_guard;
 
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
 
     //
     // One worker instance is created for each hardware thread
     // except for the main thread reserved for the ModelEngine.
-    // The worker object uses synchronization objects in its context
-    // to control its worker thread.
+    // The worker object uses the two barriers in its context
+    // to control its worker thread: both sides meet at the start barrier
+    // to begin a scan, and at the done barrier when the scan is complete.
     //
     template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class MODELHELPERTYPE, class RECORDTYPE>
     class Worker
     {
         thread workerThread_;
-        bool firstScan_ { true };
+        bool scanPending_ { false };
+        int startSense_ { 0 };
+        int doneSense_ { 0 };
         WorkerContext<OPERATORTYPE, RECORDTYPE> context_;
 
     public:
@@ -41,11 +43,14 @@ namespace embeddedpenguins::modelengine::threads
                     const ConfigurationRepository& configuration, 
                     unsigned long long int segmentStart, unsigned long long int segmentEnd, 
                     unsigned long long int& iterations, 
-                    LogLevel& loggingLevel) :
-            context_(iterations, enginePeriod, loggingLevel)
+                    LogLevel& loggingLevel, 
+                    unsigned int barrierSpinCount = DefaultBarrierSpinCount, 
+                    int cpu = -1) :
+            context_(iterations, enginePeriod, loggingLevel, barrierSpinCount)
         {
             context_.Logger.SetId(workerId);
             context_.WorkerId = workerId;
+            context_.Cpu = cpu;
             context_.RangeBegin = segmentStart;
             context_.RangeEnd = segmentEnd;
 
@@ -55,26 +60,25 @@ namespace embeddedpenguins::modelengine::threads
         void Scan(WorkCode code)
         {
             WaitForPreviousScan();
-            SetDataForScan(code);
 
-            context_.Cv.notify_one();
+            context_.Code = code;
+            context_.Tally.SignalTime = std::chrono::high_resolution_clock::now();
+            context_.StartBarrier.ArriveAndWait(startSense_);
+            scanPending_ = true;
         }
 
         void WaitForPreviousScan()
         {
-            if (firstScan_)
-            {
-                firstScan_ = false;
-                return;
-            }
-
-            unique_lock<mutex> lock(context_.MutexReturn);
-            context_.CvReturn.wait(lock, [this]{ return context_.CycleDone; });
+            if (!scanPending_) return;
+
+            context_.DoneBarrier.ArriveAndWait(doneSense_);
+            scanPending_ = false;
         }
 
         void Join()
         {
             Scan(WorkCode::Quit);
+            WaitForPreviousScan();
             workerThread_.join();
         }
 
@@ -82,14 +86,5 @@ namespace embeddedpenguins::modelengine::threads
         {
             if (workerThread_.joinable()) workerThread_.join();
         }
-
-    private:
-        void SetDataForScan(WorkCode code)
-        {
-            lock_guard<mutex> lock(context_.Mutex);
-            context_.Code = code;
-            context_.CycleDone = false;
-            context_.CycleStart = true;
-        }
     };
 }
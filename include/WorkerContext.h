@@ -1,28 +1,36 @@
 #pragma once
 
-#include <mutex>
 #include <vector>
 #include <chrono>
-#include <condition_variable>
 
 #include "Log.h"
-#include "Recorder.h"
 #include "ModelEngineCommon.h"
+#include "TickBarrier.h"
+#include "WorkChunkQueue.h"
+#include "WorkItemSorter.h"
+#include "DenseFrontier.h"
+#include "WorkRange.h"
 #include "WorkItem.h"
+#include "DirtyBlockMap.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
 
 namespace embeddedpenguins::modelengine::threads
 {
-    using std::mutex;
     using std::vector;
     using std::pair;
-    using std::condition_variable;
     using std::chrono::microseconds;
     using time_point = std::chrono::high_resolution_clock::time_point;
     using embeddedpenguins::modelengine::threads::WorkCode;
-    using embeddedpenguins::core::neuron::model::Log;
     using embeddedpenguins::core::neuron::model::LogLevel;
-    using embeddedpenguins::core::neuron::model::Recorder;
+    using embeddedpenguins::modelengine::StreamingRecorder;
+    using embeddedpenguins::modelengine::AsyncLog;
     using embeddedpenguins::modelengine::WorkItem;
+    using embeddedpenguins::modelengine::WorkItemSorter;
+    using embeddedpenguins::modelengine::DenseFrontier;
+    using embeddedpenguins::modelengine::WorkRange;
+
+    constexpr unsigned long long int DefaultWorkBufferReserve { 4096ULL };
 
     enum class CurrentBufferType
     {
@@ -30,38 +38,67 @@ namespace embeddedpenguins::modelengine::threads
         Buffer2Current
     };
 
+    //
+    // A worker's own account of its last scan.  The engine stamps the time
+    // it signalled the scan; the worker stamps the rest, and the engine reads
+    // them once the scan is done.
+    //
+    struct WorkerTally
+    {
+        time_point SignalTime {};
+        time_point WakeTime {};
+        time_point ProcessEndTime {};
+        time_point FinishTime {};
+        unsigned long long int ItemsProcessed { 0ULL };
+        unsigned long long int ItemsEmitted { 0ULL };
+    };
+
     //
     // Carry the public information defining the worker.
     // This consists primarily of synchronization between the worker and its thread.
     // Some parameters such as iteration count and engine period are actually
     // references to parameters in the ModelEngineContext.
+    // The handshake barriers and work code are written every tick by both
+    // threads, so they are kept on cache lines apart from the work vectors.
     //
     template<class OPERATORTYPE, class RECORDTYPE>
     struct WorkerContext
     {
-        mutex Mutex;
-        condition_variable Cv;
-        mutex MutexReturn;
-        condition_variable CvReturn;
-        bool CycleStart{false};
-        bool CycleDone{false};
-        WorkCode Code{WorkCode::Run};
-        microseconds& EnginePeriod;
+        TickBarrier StartBarrier;
+        TickBarrier DoneBarrier;
+        alignas(64) WorkCode Code{WorkCode::Run};
+        alignas(64) microseconds& EnginePeriod;
         unsigned long long int& Iterations;
 
         int WorkerId {0};
-        Log Logger {};
+        int Cpu {-1};
+        bool HugePageWorkBuffers {false};
+        DirtyBlockMap* DirtyBlocks {nullptr};
+        AsyncLog Logger {};
         LogLevel& LoggingLevel;
-        Recorder<RECORDTYPE> Record;
+        StreamingRecorder<RECORDTYPE> Record;
+        WorkerTally Tally {};
         unsigned long long int RangeBegin{0LL};
         unsigned long long int RangeEnd{0LL};
-        vector<WorkItem<OPERATORTYPE>> WorkForThread;
+        WorkRange<OPERATORTYPE> WorkForThread;
+        DenseFrontier<OPERATORTYPE>* Frontier {nullptr};
+        unsigned long long int FrontierFirstWord{0LL};
+        unsigned long long int FrontierLastWord{0LL};
+        vector<WorkItem<OPERATORTYPE>> FrontierBatch;
+        WorkChunkQueue Chunks;
+        vector<WorkerContext<OPERATORTYPE, RECORDTYPE>*> StealFrom;
         vector<WorkItem<OPERATORTYPE>> WorkForTick1;
+        WorkItemSorter<OPERATORTYPE> Sorter;
+        unsigned long long int PresortIndexLimit{0LL};
+        vector<vector<WorkItem<OPERATORTYPE>>> WorkForTick1ByOwner;
+        unsigned long long int OwnerStripeWidth{0LL};
         CurrentBufferType CurrentBuffer { CurrentBufferType::Buffer1Current };
         vector<WorkItem<OPERATORTYPE>> WorkForFutureTicks1;
         vector<WorkItem<OPERATORTYPE>> WorkForFutureTicks2;
 
-        WorkerContext(unsigned long long int& iterations, microseconds& enginePeriod, LogLevel& loggingLevel) : 
+        WorkerContext(unsigned long long int& iterations, microseconds& enginePeriod, LogLevel& loggingLevel, unsigned int barrierSpinCount = DefaultBarrierSpinCount) : 
+            StartBarrier(2, barrierSpinCount),
+            DoneBarrier(2, barrierSpinCount),
             Iterations(iterations), 
             Record(iterations), 
             EnginePeriod(enginePeriod), 
@@ -27,20 +27,91 @@ namespace embeddedpenguins::modelengine::threads
 
         }
 
+        //
+        // Reserve the buffers this thread fills with new work.  The worker thread
+        // calls this itself once it is pinned, so the buffers are allocated from
+        // that thread's heap arena, and their pages are first touched, and so
+        // placed, on that thread's memory node.
+        //
+        void ReserveWorkBuffers()
+        {
+            auto capacity = context_.RangeEnd - context_.RangeBegin;
+            if (capacity > DefaultWorkBufferReserve) capacity = DefaultWorkBufferReserve;
+
+            context_.WorkForTick1.reserve(capacity);
+            context_.WorkForFutureTicks1.reserve(capacity);
+            context_.WorkForFutureTicks2.reserve(capacity);
+        }
+
+        //
+        // Hand a range of the partitioner's buffer to this thread, without copying.
+        // The partitioner must keep the buffer intact until the tick is done.
+        //
         void CaptureWorkForThread(
             typename vector<WorkItem<OPERATORTYPE>>::iterator segmentBegin, 
             typename vector<WorkItem<OPERATORTYPE>>::iterator segmentEnd)
+        {
+            context_.WorkForThread.Assign(segmentBegin, segmentEnd);
+            context_.Frontier = nullptr;
+        }
+
+        //
+        // Hand a stripe of the partitioner's dense frontier to this thread,
+        // from one word of its bitmap up to another.  The thread reads back
+        // and clears the stripe as it processes it.
+        //
+        void CaptureFrontierForThread(DenseFrontier<OPERATORTYPE>& frontier, unsigned long long int firstWord, unsigned long long int lastWord)
         {
             context_.WorkForThread.clear();
-            context_.WorkForThread.insert(std::end(context_.WorkForThread), segmentBegin, segmentEnd);
+            context_.Frontier = &frontier;
+            context_.FrontierFirstWord = firstWord;
+            context_.FrontierLastWord = lastWord;
+        }
+
+        //
+        // Split the work for this thread into about the given number of chunks
+        // for work stealing.  Work must already be grouped by index, and no
+        // chunk boundary splits the work for an index, so each index is
+        // still processed by exactly one thread.
+        //
+        void SplitWorkIntoChunks(unsigned int chunkCount)
+        {
+            auto& work = context_.WorkForThread;
+            context_.Chunks.Clear();
+            if (work.empty()) return;
+
+            auto chunkSize = work.size() / (chunkCount > 0 ? chunkCount : 1);
+            if (chunkSize < 1) chunkSize = 1;
+
+            unsigned long long int chunkBegin { 0ULL };
+            while (chunkBegin < work.size())
+            {
+                auto chunkEnd = work.size() - chunkBegin <= chunkSize ? work.size() : chunkBegin + chunkSize;
+                while (chunkEnd < work.size() && work[chunkEnd].Operator.Index == work[chunkEnd - 1].Operator.Index)
+                    chunkEnd++;
+
+                context_.Chunks.Add(chunkBegin, chunkEnd);
+                chunkBegin = chunkEnd;
+            }
+        }
+
+        //
+        // Give this context one next-tick outbox per worker, so that
+        // work is routed to its owner as it is created.  All stripes
+        // are the given width, except the last, which takes the remainder.
+        //
+        void RouteWorkToOwners(int ownerCount, unsigned long long int stripeWidth)
+        {
+            context_.WorkForTick1ByOwner.resize(ownerCount);
+            context_.OwnerStripeWidth = stripeWidth > 0 ? stripeWidth : 1;
         }
 
-        bool PushIfInRange(WorkItem<OPERATORTYPE>& work)
+        bool PushIfInRange(WorkItem<OPERATORTYPE>& work, vector<WorkItem<OPERATORTYPE>>& workForThread)
         {
             auto inRange = !(work.Operator.Index < context_.RangeBegin) && (work.Operator.Index < context_.RangeEnd);
             if (!inRange) return false;
 
-            context_.WorkForThread.push_back(work);
+            workForThread.push_back(work);
             return true;
         }
     };
@@ -2,13 +2,16 @@
 
 #include <iostream>
 #include "WorkerContext.h"
+#include "WorkerContextOp.h"
 #include "ProcessCallback.h"
+#include "ScratchArena.h"
+#include "CpuPlacement.h"
+#include "HugePageAllocator.h"
 
 namespace embeddedpenguins::modelengine::threads
 {
     using std::cout;
-    using std::unique_lock;
-    using std::lock_guard;
+    using embeddedpenguins::modelengine::HugePageAdvisor;
 
     //
     // The client code implements the model algorithm by deriving a class
@@ -19,7 +22,11 @@ namespace embeddedpenguins::modelengine::threads
     // and executes the path appropriate to the work code passed in through the
     // context object.
     // Each command results in a downcast to the derived client class, and
-    // a call to the required method on that class.
+    // a call to the required method on that class.  The derived object lives
+    // as long as the thread, so any state or buffers it keeps persist
+    // across scans.
+    // Each thread also has a scratch arena, available to the derived class
+    // through Scratch(), which is reset at the start of every scan.
     //
     // NOTE the derived class is expected to implement the required methods,
     //      but no interface exists to enforce the implementation.  Run time
@@ -33,21 +40,55 @@ namespace embeddedpenguins::modelengine::threads
     template<class OPERATORTYPE, class IMPLEMENTATIONTYPE, class RECORDTYPE>
     class WorkerThread
     {
+        ScratchArena scratch_ {};
+        HugePageAdvisor hugePageAdvisor_ {};
+
     public:
         WorkerThread() = default;
 
+        ScratchArena& Scratch() { return scratch_; }
+
         void operator() (WorkerContext<OPERATORTYPE, RECORDTYPE>& context)
         {
             ProcessCallback<OPERATORTYPE, RECORDTYPE> callback(context);
 
-            while (context.Code != WorkCode::Quit)
+            if (context.Cpu >= 0 && !CpuPlacement::PinCurrentThread(context.Cpu))
+                cout << "Worker " << context.WorkerId << " could not be pinned to cpu " << context.Cpu << '\n';
+            WorkerContextOp<OPERATORTYPE, RECORDTYPE>(context).ReserveWorkBuffers();
+
+            while (true)
             {
                 WaitForSignal(context);
+                if (context.Code == WorkCode::Quit) break;
 
                 if (context.Code == WorkCode::Scan)
                 {
-                    auto derived = static_cast<IMPLEMENTATIONTYPE&>(*this);
-                    derived.Process(context.Logger, context.Record, context.Iterations, context.WorkForThread.begin(), context.WorkForThread.end(), callback);
+                    context.Tally.WakeTime = Clock::now();
+                    context.Tally.ItemsProcessed = 0ULL;
+                    context.Tally.ItemsEmitted = 0ULL;
+                    scratch_.Reset();
+
+                    auto& derived = static_cast<IMPLEMENTATIONTYPE&>(*this);
+                    if (context.Frontier != nullptr)
+                        ProcessFrontier(derived, context, callback);
+                    else if (context.StealFrom.empty())
+                    {
+                        derived.Process(context.Logger, context.Record, context.Iterations, context.WorkForThread.begin(), context.WorkForThread.end(), callback);
+                        context.Tally.ItemsProcessed += context.WorkForThread.size();
+                        if (context.DirtyBlocks)
+                            MarkDirty(*context.DirtyBlocks, context.WorkForThread.begin(), context.WorkForThread.end());
+                    }
+                    else
+                        ProcessChunks(derived, context, callback);
+                    context.Tally.ProcessEndTime = Clock::now();
+
+                    // Sort next-tick work here, in parallel, so the partitioner only has to merge.
+                    if (context.PresortIndexLimit > 0)
+                        context.Sorter.SortByIndex(context.WorkForTick1, context.PresortIndexLimit);
+
+                    if (context.HugePageWorkBuffers)
+                        AdviseWorkBuffers(context);
+                    context.Tally.FinishTime = Clock::now();
                 }
 
                 SignalDone(context);
@@ -57,20 +98,83 @@ namespace embeddedpenguins::modelengine::threads
         }
 
     private:
+        //
+        // When the tick's work is held in a dense frontier, sweep this
+        // thread's stripe of its bitmap, processing the work in batches
+        // in index order.
+        //
+        void ProcessFrontier(IMPLEMENTATIONTYPE& derived, WorkerContext<OPERATORTYPE, RECORDTYPE>& context, ProcessCallback<OPERATORTYPE, RECORDTYPE>& callback)
+        {
+            context.Frontier->ReadStripe(context.FrontierFirstWord, context.FrontierLastWord, true, context.FrontierBatch,
+                [this, &derived, &context, &callback](auto workBegin, auto workEnd)
+                {
+                    derived.Process(context.Logger, context.Record, context.Iterations, workBegin, workEnd, callback);
+                    context.Tally.ItemsProcessed += workEnd - workBegin;
+                    if (context.DirtyBlocks)
+                        MarkDirty(*context.DirtyBlocks, workBegin, workEnd);
+                });
+            context.Frontier = nullptr;
+        }
+
+        //
+        // With work stealing, process this thread's own chunks first, then steal
+        // chunks from the other workers until none are left.  Stolen work is read
+        // from the victim's WorkForThread, but any new work it creates is queued
+        // in this thread's context as usual.
+        //
+        void ProcessChunks(IMPLEMENTATIONTYPE& derived, WorkerContext<OPERATORTYPE, RECORDTYPE>& context, ProcessCallback<OPERATORTYPE, RECORDTYPE>& callback)
+        {
+            unsigned long long int chunk { 0ULL };
+            while (context.Chunks.TakeFront(chunk))
+                ProcessChunk(derived, context, context, chunk, callback);
+
+            for (auto* victim : context.StealFrom)
+                while (victim->Chunks.StealBack(chunk))
+                    ProcessChunk(derived, context, *victim, chunk, callback);
+        }
+
+        void ProcessChunk(IMPLEMENTATIONTYPE& derived, WorkerContext<OPERATORTYPE, RECORDTYPE>& context, WorkerContext<OPERATORTYPE, RECORDTYPE>& owner, unsigned long long int chunk, ProcessCallback<OPERATORTYPE, RECORDTYPE>& callback)
+        {
+            auto& range = owner.Chunks[chunk];
+            auto workBegin = owner.WorkForThread.begin();
+            derived.Process(context.Logger, context.Record, context.Iterations, workBegin + range.first, workBegin + range.second, callback);
+            context.Tally.ItemsProcessed += range.second - range.first;
+            if (context.DirtyBlocks)
+                MarkDirty(*context.DirtyBlocks, workBegin + range.first, workBegin + range.second);
+        }
+
+        //
+        // For incremental checkpoints, note the model blocks of the work just processed.
+        //
+        template<class ITERATOR>
+        void MarkDirty(DirtyBlockMap& dirtyBlocks, ITERATOR workBegin, ITERATOR workEnd)
+        {
+            for (auto work = workBegin; work != workEnd; ++work)
+                dirtyBlocks.Mark(work->Operator.Index);
+        }
+
+        //
+        // The buffers this thread fills may have grown during the scan.
+        //
+        void AdviseWorkBuffers(WorkerContext<OPERATORTYPE, RECORDTYPE>& context)
+        {
+            hugePageAdvisor_.Advise(context.WorkForTick1);
+            hugePageAdvisor_.Advise(context.WorkForFutureTicks1);
+            hugePageAdvisor_.Advise(context.WorkForFutureTicks2);
+        }
+
+        // Each barrier's local sense is owned by this thread.
+        int startSense_ { 0 };
+        int doneSense_ { 0 };
+
         void WaitForSignal(WorkerContext<OPERATORTYPE, RECORDTYPE>& context)
         {
-            unique_lock<mutex> lock(context.Mutex);
-            context.Cv.wait(lock, [&context]{ return context.CycleStart; });
-            context.CycleStart = false;
+            context.StartBarrier.ArriveAndWait(startSense_);
         }
 
         void SignalDone(WorkerContext<OPERATORTYPE, RECORDTYPE>& context)
         {
-            {
-                lock_guard<mutex> lock(context.MutexReturn);
-                context.CycleDone = true;
-            }
-            context.CvReturn.notify_one();
+            context.DoneBarrier.ArriveAndWait(doneSense_);
         }
     };
 }
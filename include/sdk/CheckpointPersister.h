@@ -0,0 +1,351 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include <unistd.h>
+
+#include "ConfigurationRepository.h"
+
+#include "IModelPersister.h"
+#include "SnapshotPersister.h"
+#include "WorkItem.h"
+
+namespace embeddedpenguins::neuron::infrastructure::persistence
+{
+    using std::string;
+    using std::vector;
+    using std::ofstream;
+
+    using embeddedpenguins::core::neuron::model::ConfigurationRepository;
+    using embeddedpenguins::modelengine::WorkItem;
+
+    constexpr unsigned int DeltaVersion { 1 };
+    constexpr char DeltaMagic[8] { 'M', 'E', 'D', 'E', 'L', 'T', 'A', '\0' };
+
+    //
+    // The fixed header at the start of every delta file.  The block table
+    // lists the model blocks the delta carries, in ascending order, and the
+    // model section holds those blocks back to back.  The last block of the
+    // model may be short.  The work sections are as in a snapshot, and
+    // replace the work of the base and of all earlier deltas.
+    //
+    struct DeltaHeader
+    {
+        char Magic[8] { };
+        unsigned int Version { DeltaVersion };
+        unsigned int NodeBytes { 0 };
+        unsigned int WorkItemBytes { 0 };
+        unsigned int SectionCount { static_cast<unsigned int>(SnapshotSection::Count) };
+        unsigned long long int Iterations { 0ULL };
+        unsigned long long int TotalWork { 0ULL };
+        unsigned long long int Chain { 0ULL };
+        unsigned long long int Sequence { 0ULL };
+        unsigned long long int NodeCount { 0ULL };
+        unsigned long long int BlockNodes { 0ULL };
+        unsigned long long int BlockCount { 0ULL };
+        unsigned long long int BlockTableOffset { 0ULL };
+        SnapshotSectionEntry Sections[static_cast<unsigned int>(SnapshotSection::Count)] { };
+    };
+
+    //
+    // Persist a running model as a chain of checkpoints: one full snapshot
+    // as the base, followed by deltas that each carry only the model blocks
+    // changed since the checkpoint before, plus all pending work.
+    // The base lives at the checkpoint path, and delta N at <path>.delta.N.
+    // Every checkpoint of a chain shares a chain id, and the base records
+    // the sequence number of the last delta already folded into it, so
+    // deltas left over from another run, or already compacted, are ignored.
+    // To restore, the base and the deltas following it are mapped, and the
+    // deltas are applied in order over the base.
+    // Compacting folds the deltas into a new base, so a restore never has
+    // to read a long chain.  It touches only files, so it may run on its
+    // own thread while the model writes newer deltas.
+    //
+    template<class OPERATORTYPE, class MODELHELPERTYPE>
+    class CheckpointPersister : public IModelPersister<MODELHELPERTYPE>
+    {
+        using NodeType = typename std::decay_t<decltype(std::declval<MODELHELPERTYPE&>().Model().Model)>::value_type;
+
+        string path_;
+        SnapshotPersister<OPERATORTYPE, MODELHELPERTYPE> base_;
+        vector<MappedSnapshotFile> deltas_ {};
+
+    public:
+        CheckpointPersister(const string& path) :
+            path_(path),
+            base_(path)
+        {
+        }
+
+        CheckpointPersister(const CheckpointPersister&) = delete;
+        CheckpointPersister& operator=(const CheckpointPersister&) = delete;
+
+        virtual ~CheckpointPersister() override = default;
+
+        const string& Path() const { return path_; }
+        const unsigned long long int Iterations() const { return deltas_.empty() ? base_.Iterations() : LastDelta().Iterations; }
+        const unsigned long long int TotalWork() const { return deltas_.empty() ? base_.TotalWork() : LastDelta().TotalWork; }
+        const unsigned long long int ModelSize() const { return base_.ModelSize(); }
+        const unsigned long long int Chain() const { return base_.Chain(); }
+        const unsigned long long int Sequence() const { return base_.Sequence() + deltas_.size(); }
+        const unsigned long long int DeltaCount() const { return deltas_.size(); }
+
+        static string DeltaPath(const string& path, unsigned long long int sequence)
+        {
+            return path + ".delta." + std::to_string(sequence);
+        }
+
+        //
+        // Start a chain with a full snapshot of the model.
+        //
+        bool WriteBase(MODELHELPERTYPE& helper, unsigned long long int iterations, unsigned long long int totalWork, const SnapshotWork<OPERATORTYPE>& work, unsigned long long int chain)
+        {
+            return base_.Write(helper, iterations, totalWork, work, chain, 0ULL);
+        }
+
+        //
+        // Write the given model blocks and all pending work as the next delta
+        // of a chain, first to a temporary file which then replaces the delta.
+        //
+        bool WriteDelta(MODELHELPERTYPE& helper, unsigned long long int iterations, unsigned long long int totalWork, const SnapshotWork<OPERATORTYPE>& work, unsigned long long int chain, unsigned long long int sequence, const vector<unsigned long long int>& blocks, unsigned long long int blockNodes)
+        {
+            auto& model = helper.Model().Model;
+            auto nodeCount = static_cast<unsigned long long int>(model.size());
+
+            DeltaHeader header {};
+            std::memcpy(header.Magic, DeltaMagic, sizeof(header.Magic));
+            header.NodeBytes = sizeof(NodeType);
+            header.WorkItemBytes = sizeof(WorkItem<OPERATORTYPE>);
+            header.Iterations = iterations;
+            header.TotalWork = totalWork;
+            header.Chain = chain;
+            header.Sequence = sequence;
+            header.NodeCount = nodeCount;
+            header.BlockNodes = blockNodes;
+            header.BlockCount = blocks.size();
+
+            unsigned long long int blockDataNodes { 0ULL };
+            for (auto block : blocks)
+                blockDataNodes += BlockLength(block, blockNodes, nodeCount);
+
+            header.BlockTableOffset = AlignUp(sizeof(DeltaHeader), SnapshotWorkAlignment);
+            auto offset = AlignUp(header.BlockTableOffset + blocks.size() * sizeof(unsigned long long int), SnapshotWorkAlignment);
+            SetSection(header, SnapshotSection::Model, offset, blockDataNodes, sizeof(NodeType));
+            SetSection(header, SnapshotSection::WorkForTick, offset, work.WorkForTick.size(), sizeof(WorkItem<OPERATORTYPE>));
+            SetSection(header, SnapshotSection::Backlog, offset, work.Backlog.size(), sizeof(WorkItem<OPERATORTYPE>));
+            SetSection(header, SnapshotSection::FutureWork, offset, work.FutureWork.size(), sizeof(WorkItem<OPERATORTYPE>));
+            SetSection(header, SnapshotSection::NextTickWork, offset, work.NextTickWork.size(), sizeof(WorkItem<OPERATORTYPE>));
+
+            auto deltaPath = DeltaPath(path_, sequence);
+            auto temporaryPath = deltaPath + ".partial";
+            {
+                ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                if (!file) return false;
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                WriteAt(file, header.BlockTableOffset, blocks.data(), blocks.size() * sizeof(unsigned long long int));
+                WriteAt(file, Section(header, SnapshotSection::Model).Offset, nullptr, 0ULL);
+                for (auto block : blocks)
+                    file.write(reinterpret_cast<const char*>(model.data() + block * blockNodes), BlockLength(block, blockNodes, nodeCount) * sizeof(NodeType));
+                WriteWorkSection(file, header, SnapshotSection::WorkForTick, work.WorkForTick);
+                WriteWorkSection(file, header, SnapshotSection::Backlog, work.Backlog);
+                WriteWorkSection(file, header, SnapshotSection::FutureWork, work.FutureWork);
+                WriteWorkSection(file, header, SnapshotSection::NextTickWork, work.NextTickWork);
+
+                file.flush();
+                if (!file) return false;
+            }
+
+            return std::rename(temporaryPath.c_str(), deltaPath.c_str()) == 0;
+        }
+
+        //
+        // Map the base, and every delta of its chain that follows it
+        // without a gap.  A plain snapshot loads as a base without deltas.
+        //
+        virtual bool LoadConfiguration() override
+        {
+            deltas_.clear();
+            if (!base_.LoadConfiguration()) return false;
+            if (base_.Chain() == 0ULL) return true;
+
+            for (auto sequence = base_.Sequence() + 1; ; sequence++)
+            {
+                MappedSnapshotFile delta {};
+                if (!delta.Map(DeltaPath(path_, sequence)) || !IsValidDelta(delta, sequence)) break;
+                deltas_.push_back(std::move(delta));
+            }
+
+            return true;
+        }
+
+        //
+        // Copy the base model out, then apply the deltas in order.
+        //
+        virtual bool ReadModel(MODELHELPERTYPE& helper, const ConfigurationRepository& configuration) override
+        {
+            if (!base_.ReadModel(helper, configuration)) return false;
+
+            ApplyDeltas(helper.Model().Model.data());
+            return true;
+        }
+
+        //
+        // The pending work is that of the last checkpoint in the chain.
+        //
+        bool ReadWork(SnapshotWork<OPERATORTYPE>& work) const
+        {
+            if (deltas_.empty()) return base_.ReadWork(work);
+
+            const auto& delta = deltas_.back();
+            ReadWorkSection(delta, SnapshotSection::WorkForTick, work.WorkForTick);
+            ReadWorkSection(delta, SnapshotSection::Backlog, work.Backlog);
+            ReadWorkSection(delta, SnapshotSection::FutureWork, work.FutureWork);
+            ReadWorkSection(delta, SnapshotSection::NextTickWork, work.NextTickWork);
+            return true;
+        }
+
+        //
+        // Fold every delta following the base into a new base, then remove
+        // those deltas.  The new base replaces the old one in a single rename,
+        // and records the last delta it holds, so the chain stays readable if
+        // compaction is interrupted at any point.  The model is rebuilt in
+        // memory, so this briefly needs room for a second copy of it.
+        //
+        bool Compact()
+        {
+            if (!LoadConfiguration()) return false;
+            if (deltas_.empty()) return true;
+
+            vector<NodeType> model(ModelSize());
+            base_.CopyModel(model.data());
+            ApplyDeltas(model.data());
+
+            SnapshotWork<OPERATORTYPE> work {};
+            ReadWork(work);
+
+            auto firstSequence = base_.Sequence() + 1;
+            auto lastSequence = Sequence();
+            SnapshotPersister<OPERATORTYPE, MODELHELPERTYPE> compacted(path_);
+            if (!compacted.Write(model.data(), model.size(), Iterations(), TotalWork(), work, Chain(), lastSequence))
+                return false;
+
+            deltas_.clear();
+            for (auto sequence = firstSequence; sequence <= lastSequence; sequence++)
+                unlink(DeltaPath(path_, sequence).c_str());
+
+            return LoadConfiguration();
+        }
+
+    private:
+        const DeltaHeader& Header(const MappedSnapshotFile& delta) const
+        {
+            return *reinterpret_cast<const DeltaHeader*>(delta.Data());
+        }
+
+        const DeltaHeader& LastDelta() const
+        {
+            return Header(deltas_.back());
+        }
+
+        bool IsValidDelta(const MappedSnapshotFile& delta, unsigned long long int sequence) const
+        {
+            if (delta.Size() < sizeof(DeltaHeader)) return false;
+
+            const auto& header = Header(delta);
+            if (std::memcmp(header.Magic, DeltaMagic, sizeof(header.Magic)) != 0) return false;
+            if (header.Version != DeltaVersion) return false;
+            if (header.NodeBytes != sizeof(NodeType) || header.WorkItemBytes != sizeof(WorkItem<OPERATORTYPE>)) return false;
+            if (header.SectionCount != static_cast<unsigned int>(SnapshotSection::Count)) return false;
+            if (header.Chain != base_.Chain() || header.Sequence != sequence) return false;
+            if (header.NodeCount != base_.ModelSize() || header.BlockNodes == 0) return false;
+            if (header.BlockTableOffset > delta.Size() || header.BlockCount > (delta.Size() - header.BlockTableOffset) / sizeof(unsigned long long int)) return false;
+
+            return delta.SectionsFit(header.Sections, header.SectionCount, header.NodeBytes, header.WorkItemBytes);
+        }
+
+        //
+        // Copy the blocks of each delta over the model, in chain order.
+        // Blocks that do not fit the model or the delta are skipped.
+        //
+        void ApplyDeltas(NodeType* model) const
+        {
+            for (const auto& delta : deltas_)
+            {
+                const auto& header = Header(delta);
+                const auto* blocks = reinterpret_cast<const unsigned long long int*>(delta.Data() + header.BlockTableOffset);
+                const auto* source = reinterpret_cast<const NodeType*>(delta.Data() + Section(header, SnapshotSection::Model).Offset);
+                auto sourceEnd = source + Section(header, SnapshotSection::Model).Count;
+
+                for (auto entry = 0ULL; entry < header.BlockCount; entry++)
+                {
+                    auto block = blocks[entry];
+                    if (block * header.BlockNodes >= header.NodeCount) break;
+
+                    auto length = BlockLength(block, header.BlockNodes, header.NodeCount);
+                    if (length > static_cast<unsigned long long int>(sourceEnd - source)) break;
+
+                    std::memcpy(model + block * header.BlockNodes, source, length * sizeof(NodeType));
+                    source += length;
+                }
+            }
+        }
+
+        static unsigned long long int BlockLength(unsigned long long int block, unsigned long long int blockNodes, unsigned long long int nodeCount)
+        {
+            return std::min(blockNodes, nodeCount - block * blockNodes);
+        }
+
+        static const SnapshotSectionEntry& Section(const DeltaHeader& header, SnapshotSection section)
+        {
+            return header.Sections[static_cast<unsigned int>(section)];
+        }
+
+        static void ReadWorkSection(const MappedSnapshotFile& delta, SnapshotSection section, vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            const auto& entry = reinterpret_cast<const DeltaHeader*>(delta.Data())->Sections[static_cast<unsigned int>(section)];
+            const auto* source = reinterpret_cast<const WorkItem<OPERATORTYPE>*>(delta.Data() + entry.Offset);
+            work.assign(source, source + entry.Count);
+        }
+
+        static unsigned long long int AlignUp(unsigned long long int offset, unsigned long long int alignment)
+        {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        static void SetSection(DeltaHeader& header, SnapshotSection section, unsigned long long int& offset, unsigned long long int count, unsigned long long int itemBytes)
+        {
+            header.Sections[static_cast<unsigned int>(section)] = SnapshotSectionEntry { offset, count };
+            offset = AlignUp(offset + count * itemBytes, SnapshotWorkAlignment);
+        }
+
+        static void WriteWorkSection(ofstream& file, const DeltaHeader& header, SnapshotSection section, const vector<WorkItem<OPERATORTYPE>>& work)
+        {
+            WriteAt(file, Section(header, section).Offset, work.data(), work.size() * sizeof(WorkItem<OPERATORTYPE>));
+        }
+
+        //
+        // Pad the file out to the given offset, then write.
+        //
+        static void WriteAt(ofstream& file, unsigned long long int offset, const void* data, unsigned long long int bytes)
+        {
+            static const char padding[SnapshotWorkAlignment] { };
+
+            auto position = static_cast<unsigned long long int>(file.tellp());
+            while (position < offset)
+            {
+                auto paddingBytes = std::min(offset - position, SnapshotWorkAlignment);
+                file.write(padding, paddingBytes);
+                position += paddingBytes;
+            }
+            if (bytes > 0) file.write(static_cast<const char*>(data), bytes);
+        }
+    };
+}
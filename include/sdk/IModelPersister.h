@@ -13,7 +13,7 @@ namespace embeddedpenguins::neuron::infrastructure::persistence
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
 
     //
-    // TODO: Use this interface for persistence of the current state of a model.
+    // Save and restore the current state of a model, as snapshots and checkpoints do.
     //
     template<class MODELHELPERTYPE>
     class IModelPersister
@@ -7,6 +7,8 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <limits>
 
 #include "nlohmann/json.hpp"
 
@@ -84,6 +86,27 @@ namespace embeddedpenguins::modelengine::sdk
             return RunModelEngine(helper);
         }
 
+        //
+        // Ensure the model is created and initialized, then run it
+        // as fast as possible for the given number of ticks, or until
+        // no work is queued if requested.  Return when the model engine
+        // has stopped, after reporting the throughput of the run.
+        //
+        bool RunTicks(MODELHELPERTYPE& helper, unsigned long long int ticks, bool stopWhenIdle = false)
+        {
+            if (!valid_)
+                return false;
+
+            modelEngine_ = make_unique<ModelEngine<OPERATORTYPE, IMPLEMENTATIONTYPE, MODELHELPERTYPE, RECORDTYPE>>(
+                helper, 
+                configuration_);
+
+            modelEngine_->RunTicks(ticks, stopWhenIdle);
+            ReportThroughput();
+
+            return true;
+        }
+
         //
         // Start an async process to stop the model engine
         // and return immediately.  To guarantee it has stopped,
@@ -140,6 +163,19 @@ namespace embeddedpenguins::modelengine::sdk
             valid_ = true;
         }
 
+        void ReportThroughput()
+        {
+            auto iterations = modelEngine_->GetIterations();
+            auto totalWork = modelEngine_->GetTotalWork();
+            auto seconds = std::chrono::duration<double>(modelEngine_->GetRunTime()).count();
+            if (seconds <= 0.0) seconds = std::numeric_limits<double>::min();
+
+            cout 
+                << "Ran " << iterations << " ticks with " << totalWork << " work items in " << seconds << " s: "
+                << iterations / seconds << " ticks/s, " 
+                << totalWork / seconds << " work items/s\n";
+        }
+
         bool RunModelEngine(MODELHELPERTYPE& helper)
         {
             // Create and run the model engine.
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "ConfigurationRepository.h"
+
+#include "IModelPersister.h"
+#include "WorkItem.h"
+
+namespace embeddedpenguins::neuron::infrastructure::persistence
+{
+    using std::string;
+    using std::vector;
+    using std::thread;
+    using std::ofstream;
+
+    using embeddedpenguins::core::neuron::model::ConfigurationRepository;
+    using embeddedpenguins::modelengine::WorkItem;
+
+    enum class SnapshotSection : unsigned int
+    {
+        Model,
+        WorkForTick,
+        Backlog,
+        FutureWork,
+        NextTickWork,
+        Count
+    };
+
+    constexpr unsigned int SnapshotVersion { 2 };
+    constexpr char SnapshotMagic[8] { 'M', 'E', 'S', 'N', 'A', 'P', '\0', '\0' };
+    constexpr unsigned long long int SnapshotModelAlignment { 4096ULL };
+    constexpr unsigned long long int SnapshotWorkAlignment { 64ULL };
+
+    struct SnapshotSectionEntry
+    {
+        unsigned long long int Offset { 0ULL };
+        unsigned long long int Count { 0ULL };
+    };
+
+    //
+    // The fixed header at the start of every snapshot file.  Each section
+    // is a packed array of model nodes or work items, at the recorded offset.
+    // The model starts on a page boundary, so it may be mapped directly.
+    // A snapshot used as a checkpoint base records the chain of deltas that
+    // may be applied to it, and the sequence number of the last one it includes.
+    //
+    struct SnapshotHeader
+    {
+        char Magic[8] { };
+        unsigned int Version { SnapshotVersion };
+        unsigned int NodeBytes { 0 };
+        unsigned int WorkItemBytes { 0 };
+        unsigned int SectionCount { static_cast<unsigned int>(SnapshotSection::Count) };
+        unsigned long long int Iterations { 0ULL };
+        unsigned long long int TotalWork { 0ULL };
+        unsigned long long int Chain { 0ULL };
+        unsigned long long int Sequence { 0ULL };
+        SnapshotSectionEntry Sections[static_cast<unsigned int>(SnapshotSection::Count)] { };
+    };
+
+    //
+    // A whole file mapped read-only.
+    //
+    class MappedSnapshotFile
+    {
+        void* mapping_ { MAP_FAILED };
+        size_t bytes_ { 0 };
+
+    public:
+        MappedSnapshotFile() = default;
+        MappedSnapshotFile(const MappedSnapshotFile&) = delete;
+        MappedSnapshotFile& operator=(const MappedSnapshotFile&) = delete;
+        MappedSnapshotFile(MappedSnapshotFile&& other) noexcept : mapping_(other.mapping_), bytes_(other.bytes_) { other.mapping_ = MAP_FAILED; other.bytes_ = 0; }
+        MappedSnapshotFile& operator=(MappedSnapshotFile&& other) noexcept { std::swap(mapping_, other.mapping_); std::swap(bytes_, other.bytes_); return *this; }
+        ~MappedSnapshotFile() { Unmap(); }
+
+        const bool Mapped() const { return mapping_ != MAP_FAILED; }
+        const char* Data() const { return static_cast<const char*>(mapping_); }
+        const size_t Size() const { return bytes_; }
+
+        bool Map(const string& path)
+        {
+            Unmap();
+
+            auto fileDescriptor = open(path.c_str(), O_RDONLY);
+            if (fileDescriptor < 0) return false;
+
+            struct stat fileStatus;
+            if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size == 0)
+            {
+                close(fileDescriptor);
+                return false;
+            }
+
+            bytes_ = fileStatus.st_size;
+            mapping_ = mmap(nullptr, bytes_, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            close(fileDescriptor);
+            if (mapping_ == MAP_FAILED) bytes_ = 0;
+
+            return Mapped();
+        }
+
+        void Unmap()
+        {
+            if (mapping_ != MAP_FAILED) munmap(mapping_, bytes_);
+            mapping_ = MAP_FAILED;
+            bytes_ = 0;
+        }
+
+        //
+        // Check that each section lies wholly inside the file.
+        //
+        bool SectionsFit(const SnapshotSectionEntry* sections, unsigned int sectionCount, unsigned long long int modelItemBytes, unsigned long long int workItemBytes) const
+        {
+            for (auto section = 0U; section < sectionCount; section++)
+            {
+                auto itemBytes = (section == static_cast<unsigned int>(SnapshotSection::Model)) ? modelItemBytes : workItemBytes;
+                auto& entry = sections[section];
+                if (itemBytes == 0 || entry.Offset > bytes_ || entry.Count > (bytes_ - entry.Offset) / itemBytes) return false;
+            }
+
+            return true;
+        }
+    };
+
+    //
+    // All work pending at a tick boundary, gathered into four sets:
+    // the work already handed to the workers for the upcoming tick, the
+    // work the partitioner holds for later ticks, and the future and
+    // next-tick work the workers have created but not yet handed over.
+    //
+    template<class OPERATORTYPE>
+    struct SnapshotWork
+    {
+        vector<WorkItem<OPERATORTYPE>> WorkForTick {};
+        vector<WorkItem<OPERATORTYPE>> Backlog {};
+        vector<WorkItem<OPERATORTYPE>> FutureWork {};
+        vector<WorkItem<OPERATORTYPE>> NextTickWork {};
+    };
+
+    //
+    // Persist the full state of a running model as a binary snapshot:
+    // the model, the tick, and all pending work.  The node and operator
+    // types are written as raw memory, so they must be trivially copyable,
+    // and a snapshot may only be restored by the same build of a model.
+    // To restore, the file is mapped rather than read, and the model is
+    // copied out of the mapping by several threads at once.
+    //
+    template<class OPERATORTYPE, class MODELHELPERTYPE>
+    class SnapshotPersister : public IModelPersister<MODELHELPERTYPE>
+    {
+        using NodeType = typename std::decay_t<decltype(std::declval<MODELHELPERTYPE&>().Model().Model)>::value_type;
+        static_assert(std::is_trivially_copyable_v<NodeType>, "Model nodes must be trivially copyable to be snapshotted");
+        static_assert(std::is_trivially_copyable_v<WorkItem<OPERATORTYPE>>, "Operators must be trivially copyable to be snapshotted");
+
+        string path_;
+        MappedSnapshotFile file_ {};
+        const SnapshotHeader* header_ { nullptr };
+
+    public:
+        SnapshotPersister(const string& path) :
+            path_(path)
+        {
+        }
+
+        SnapshotPersister(const SnapshotPersister&) = delete;
+        SnapshotPersister& operator=(const SnapshotPersister&) = delete;
+
+        virtual ~SnapshotPersister() override = default;
+
+        const string& Path() const { return path_; }
+        const unsigned long long int Iterations() const { return header_ ? header_->Iterations : 0ULL; }
+        const unsigned long long int TotalWork() const { return header_ ? header_->TotalWork : 0ULL; }
+        const unsigned long long int ModelSize() const { return header_ ? Section(SnapshotSection::Model).Count : 0ULL; }
+        const unsigned long long int Chain() const { return header_ ? header_->Chain : 0ULL; }
+        const unsigned long long int Sequence() const { return header_ ? header_->Sequence : 0ULL; }
+        const SnapshotHeader* Header() const { return header_; }
+        const MappedSnapshotFile& File() const { return file_; }
+
+        //
+        // Write a snapshot, first to a temporary file which then replaces
+        // the snapshot file, so an interrupted write never leaves a torn snapshot.
+        //
+        bool Write(MODELHELPERTYPE& helper, unsigned long long int iterations, unsigned long long int totalWork, const SnapshotWork<OPERATORTYPE>& work, unsigned long long int chain = 0ULL, unsigned long long int sequence = 0ULL)
+        {
+            auto& model = helper.Model().Model;
+            return Write(model.data(), model.size(), iterations, totalWork, work, chain, sequence);
+        }
+
+        bool Write(const NodeType* model, unsigned long long int nodeCount, unsigned long long int iterations, unsigned long long int totalWork, const SnapshotWork<OPERATORTYPE>& work, unsigned long long int chain = 0ULL, unsigned long long int sequence = 0ULL)
+        {
+            SnapshotHeader header {};
+            std::memcpy(header.Magic, SnapshotMagic, sizeof(header.Magic));
+            header.NodeBytes = sizeof(NodeType);
+            header.WorkItemBytes = sizeof(WorkItem<OPERATORTYPE>);
+            header.Iterations = iterations;
+            header.TotalWork = totalWork;
+            header.Chain = chain;
+            header.Sequence = sequence;
+
+            auto offset = AlignUp(sizeof(SnapshotHeader), SnapshotModelAlignment);
+            SetSection(header, SnapshotSection::Model, offset, nodeCount, sizeof(NodeType));
+            SetSection(header, SnapshotSection::WorkForTick, offset, work.WorkForTick.size(), sizeof(WorkItem<OPERATORTYPE>));
+            SetSection(header, SnapshotSection::Backlog, offset, work.Backlog.size(), sizeof(WorkItem<OPERATORTYPE>));
+            SetSection(header, SnapshotSection::FutureWork, offset, work.FutureWork.size(), sizeof(WorkItem<OPERATORTYPE>));
+            SetSection(header, SnapshotSection::NextTickWork, offset, work.NextTickWork.size(), sizeof(WorkItem<OPERATORTYPE>));
+
+            auto temporaryPath = path_ + ".partial";
+            {
+                ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+                if (!file) return false;
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                WriteSection(file, header, SnapshotSection::Model, model, nodeCount * sizeof(NodeType));
+                WriteSection(file, header, SnapshotSection::WorkForTick, work.WorkForTick.data(), work.WorkForTick.size() * sizeof(WorkItem<OPERATORTYPE>));
+                WriteSection(file, header, SnapshotSection::Backlog, work.Backlog.data(), work.Backlog.size() * sizeof(WorkItem<OPERATORTYPE>));
+                WriteSection(file, header, SnapshotSection::FutureWork, work.FutureWork.data(), work.FutureWork.size() * sizeof(WorkItem<OPERATORTYPE>));
+                WriteSection(file, header, SnapshotSection::NextTickWork, work.NextTickWork.data(), work.NextTickWork.size() * sizeof(WorkItem<OPERATORTYPE>));
+
+                file.flush();
+                if (!file) return false;
+            }
+
+            return std::rename(temporaryPath.c_str(), path_.c_str()) == 0;
+        }
+
+        //
+        // Map the snapshot file and check that it was written for this model.
+        //
+        virtual bool LoadConfiguration() override
+        {
+            header_ = nullptr;
+            if (!file_.Map(path_) || file_.Size() < sizeof(SnapshotHeader)) return false;
+
+            header_ = reinterpret_cast<const SnapshotHeader*>(file_.Data());
+            if (!IsValid())
+            {
+                header_ = nullptr;
+                file_.Unmap();
+                return false;
+            }
+
+            return true;
+        }
+
+        //
+        // Copy the model out of the mapped snapshot, resizing it if needed.
+        //
+        virtual bool ReadModel(MODELHELPERTYPE& helper, const ConfigurationRepository& /*configuration*/) override
+        {
+            if (!header_) return false;
+
+            auto& model = helper.Model().Model;
+            auto nodeCount = Section(SnapshotSection::Model).Count;
+            if (model.size() != nodeCount) model.resize(nodeCount);
+
+            CopyModel(model.data());
+            return true;
+        }
+
+        //
+        // Copy the model out of the mapped snapshot into room for ModelSize() nodes,
+        // several threads at once.
+        //
+        void CopyModel(NodeType* target) const
+        {
+            auto nodeCount = Section(SnapshotSection::Model).Count;
+            const auto* source = reinterpret_cast<const NodeType*>(SectionData(SnapshotSection::Model));
+            auto threadCount = std::max(1ULL, std::min(static_cast<unsigned long long int>(std::thread::hardware_concurrency()), nodeCount / 1024 + 1));
+            auto segmentSize = nodeCount / threadCount;
+
+            vector<thread> copyThreads {};
+            for (auto segment = 0ULL; segment < threadCount; segment++)
+            {
+                auto segmentBegin = segment * segmentSize;
+                auto segmentEnd = (segment == threadCount - 1) ? nodeCount : segmentBegin + segmentSize;
+                copyThreads.push_back(thread([target, source, segmentBegin, segmentEnd]()
+                    {
+                        std::memcpy(target + segmentBegin, source + segmentBegin, (segmentEnd - segmentBegin) * sizeof(NodeType));
+                    }));
+            }
+
+            for (auto& copyThread : copyThreads)
+                copyThread.join();
+        }
+
+        bool ReadWork(SnapshotWork<OPERATORTYPE>& work) const
+        {
+            if (!header_) return false;
+
+            ReadWorkSection(SnapshotSection::WorkForTick, work.WorkForTick);
+            ReadWorkSection(SnapshotSection::Backlog, work.Backlog);
+            ReadWorkSection(SnapshotSection::FutureWork, work.FutureWork);
+            ReadWorkSection(SnapshotSection::NextTickWork, work.NextTickWork);
+            return true;
+        }
+
+    private:
+        bool IsValid() const
+        {
+            if (std::memcmp(header_->Magic, SnapshotMagic, sizeof(header_->Magic)) != 0) return false;
+            if (header_->Version != SnapshotVersion) return false;
+            if (header_->NodeBytes != sizeof(NodeType) || header_->WorkItemBytes != sizeof(WorkItem<OPERATORTYPE>)) return false;
+            if (header_->SectionCount != static_cast<unsigned int>(SnapshotSection::Count)) return false;
+
+            return file_.SectionsFit(header_->Sections, header_->SectionCount, header_->NodeBytes, header_->WorkItemBytes);
+        }
+
+        const SnapshotSectionEntry& Section(SnapshotSection section) const
+        {
+            return header_->Sections[static_cast<unsigned int>(section)];
+        }
+
+        const char* SectionData(SnapshotSection section) const
+        {
+            return file_.Data() + Section(section).Offset;
+        }
+
+        void ReadWorkSection(SnapshotSection section, vector<WorkItem<OPERATORTYPE>>& work) const
+        {
+            const auto* source = reinterpret_cast<const WorkItem<OPERATORTYPE>*>(SectionData(section));
+            work.assign(source, source + Section(section).Count);
+        }
+
+        static unsigned long long int AlignUp(unsigned long long int offset, unsigned long long int alignment)
+        {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        static void SetSection(SnapshotHeader& header, SnapshotSection section, unsigned long long int& offset, unsigned long long int count, unsigned long long int itemBytes)
+        {
+            header.Sections[static_cast<unsigned int>(section)] = SnapshotSectionEntry { offset, count };
+            offset = AlignUp(offset + count * itemBytes, SnapshotWorkAlignment);
+        }
+
+        static void WriteSection(ofstream& file, const SnapshotHeader& header, SnapshotSection section, const void* data, unsigned long long int bytes)
+        {
+            static const char padding[SnapshotModelAlignment] { };
+
+            auto position = static_cast<unsigned long long int>(file.tellp());
+            auto offset = header.Sections[static_cast<unsigned int>(section)].Offset;
+            if (offset > position) file.write(padding, offset - position);
+            if (bytes > 0) file.write(static_cast<const char*>(data), bytes);
+        }
+    };
+}
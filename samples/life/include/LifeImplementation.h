@@ -9,8 +9,8 @@
 #include "WorkerThread.h"
 #include "WorkItem.h"
 #include "ProcessCallback.h"
-#include "Recorder.h"
-#include "Log.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
 
 #include "LifeCommon.h"
 #include "LifeSupport.h"
@@ -23,13 +23,12 @@ namespace embeddedpenguins::life::infrastructure
 {
     using std::cout;
     using std::vector;
-    using std::unique;
 
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
     using ::embeddedpenguins::modelengine::threads::WorkerThread;
     using ::embeddedpenguins::modelengine::threads::ProcessCallback;
-    using embeddedpenguins::core::neuron::model::Log;
-    using embeddedpenguins::core::neuron::model::Recorder;
+    using embeddedpenguins::modelengine::AsyncLog;
+    using embeddedpenguins::modelengine::StreamingRecorder;
     using ::embeddedpenguins::modelengine::WorkItem;
 
     //
@@ -100,7 +99,7 @@ namespace embeddedpenguins::life::infrastructure
         // here each tick to provide new input from external to the model.
         // It is up to the implementation to connect to the external source.
         //
-        void StreamNewInputWork(Log& log, Recorder<LifeRecord>& record, 
+        void StreamNewInputWork(AsyncLog& log, StreamingRecorder<LifeRecord>& record, 
             unsigned long long int tickNow, 
             ProcessCallback<LifeOperation, LifeRecord>& callback)
         {
@@ -121,25 +120,30 @@ namespace embeddedpenguins::life::infrastructure
         // Process the work items described by the iterators in whatever
         // manner is appropriate to the model.
         //
-        void Process(Log& log, Recorder<LifeRecord>& record, 
+        void Process(AsyncLog& log, StreamingRecorder<LifeRecord>& record, 
             unsigned long long int tickNow, 
             typename vector<WorkItem<LifeOperation>>::iterator begin, 
             typename vector<WorkItem<LifeOperation>>::iterator end, 
             ProcessCallback<LifeOperation, LifeRecord>& callback)
         {
-            if (end - begin == 0) return;
-
             // The work items tend to explode exponentially if we process duplicate work items.
-            // Here we reduce the work load to include exactly one instance of each index.
-            vector<WorkItem<LifeOperation>> localWork(begin, end);
-            auto endIt = unique(localWork.begin(), localWork.end(), 
-                [](const WorkItem<LifeOperation>& first, const WorkItem<LifeOperation>& second)
+            // LifeOperation::Combine() has the adaptive partitioners merge them when coalescing
+            // is on; otherwise, skip repeats of an operation on an index here.  Only a run of
+            // work for one index is checked, which finds them all when work is grouped by index.
+            auto index { 0ULL };
+            unsigned int opsDone { 0U };
+            for (auto work = begin; work != end; work++)
+            {
+                if (work == begin || work->Operator.Index != index)
                 {
-                    return first.Operator.Index == second.Operator.Index;
-                });
+                    index = work->Operator.Index;
+                    opsDone = 0U;
+                }
+
+                auto op = 1U << static_cast<unsigned int>(work->Operator.Op);
+                if (opsDone & op) continue;
+                opsDone |= op;
 
-            for (auto work = localWork.begin(); work != endIt; work++)
-            {
                 ProcessWorkItem(log, record, tickNow, work->Operator, callback);
             }
         }
@@ -157,7 +161,7 @@ namespace embeddedpenguins::life::infrastructure
             helper.InitializeCells(initializedCells_);
         }
 
-        void ProcessWorkItem(Log& log, Recorder<LifeRecord>& record, 
+        void ProcessWorkItem(AsyncLog& log, StreamingRecorder<LifeRecord>& record, 
             unsigned long long int tickNow, 
             const LifeOperation& work, 
             ProcessCallback<LifeOperation, LifeRecord>& callback)
@@ -187,7 +191,7 @@ namespace embeddedpenguins::life::infrastructure
         // next tick and signal a propagate operation for this cell
         // in the next tick.
         //
-        void ProcessEvaluation(Log& log, Recorder<LifeRecord>& record, 
+        void ProcessEvaluation(AsyncLog& log, StreamingRecorder<LifeRecord>& record, 
             unsigned long long int cellIndex, 
             ProcessCallback<LifeOperation, LifeRecord>& callback)
         {
@@ -199,8 +203,7 @@ namespace embeddedpenguins::life::infrastructure
                 lifeNode.AliveNextTick = aliveNextTick;
 
 #ifndef NOLOG
-                log.Logger() << "Cell " << cellIndex << " changing evaluation to " << (lifeNode.AliveNextTick ? "alive" : "dead") << " for next propagation" << '\n';
-                log.Logit();
+                log.Write("Cell {} changing evaluation to {} for next propagation\n", cellIndex, lifeNode.AliveNextTick ? "alive" : "dead");
 #endif
                 callback(LifeOperation(cellIndex, Operation::Propagate));
             }
@@ -212,18 +215,17 @@ namespace embeddedpenguins::life::infrastructure
         // state, then signal all surrounding cells to evaluate
         // in the next tick.
         //
-        void ProcessPropagation(Log& log, Recorder<LifeRecord>& record, 
+        void ProcessPropagation(AsyncLog& log, StreamingRecorder<LifeRecord>& record, 
             unsigned long long int cellIndex, 
             ProcessCallback<LifeOperation, LifeRecord>& callback)
         {
             auto& lifeNode = helper_.Model().Model[cellIndex];
  
 #ifndef NOLOG
-            log.Logger() << "Cell " << cellIndex << " propagating to " << (lifeNode.AliveNextTick ? "alive" : "dead") << '\n';
-            log.Logit();
+            log.Write("Cell {} propagating to {}\n", cellIndex, lifeNode.AliveNextTick ? "alive" : "dead");
 #endif
             lifeNode.Alive = lifeNode.AliveNextTick;
-            record.Record(LifeRecord(LifeRecordType::Propagate, cellIndex, lifeNode));
+            record.Record(LifeRecord(LifeRecordType::Propagate, helper_.Layout().ToGrid(cellIndex), lifeNode));
 
             SignalAllSurroundingCellsToEvaluate(cellIndex, callback);
         }
@@ -253,16 +255,20 @@ namespace embeddedpenguins::life::infrastructure
         // Given a cell index in the model, apply the rules table to that
         // cell (taking into account the surrounding eight cells), and
         // return the life state of that cell for the next tick.
+        // Neighbours are found on the grid, then looked up where the
+        // layout stores them.
         //
         bool ApplyRulesOfLife(unsigned long long int cellIndex)
         {
+            auto& layout = helper_.Layout();
+            auto gridIndex = layout.ToGrid(cellIndex);
             unsigned short int surround {};
             unsigned short int bitmask { 0x1 };
-            for (auto rowStep = cellIndex - width_; rowStep < cellIndex + width_ + 1; rowStep += width_)
+            for (auto rowStep = gridIndex - width_; rowStep < gridIndex + width_ + 1; rowStep += width_)
             {
                 for (auto step = rowStep - 1; step < rowStep + 2; step++)
                 {
-                    if (step < maxIndex_ && helper_.Model().Model[step].Alive) surround |= bitmask;
+                    if (step < maxIndex_ && helper_.Model().Model[layout.ToStorage(step)].Alive) surround |= bitmask;
                     bitmask <<= 1;
                 }
             }
@@ -272,11 +278,13 @@ namespace embeddedpenguins::life::infrastructure
 
         void SignalAllSurroundingCellsToEvaluate(unsigned long long int cellIndex, ProcessCallback<LifeOperation, LifeRecord>& callback)
         {
-            for (auto rowStep = cellIndex - width_; rowStep < cellIndex + width_ + 1; rowStep += width_)
+            auto& layout = helper_.Layout();
+            auto gridIndex = layout.ToGrid(cellIndex);
+            for (auto rowStep = gridIndex - width_; rowStep < gridIndex + width_ + 1; rowStep += width_)
             {
                 for (auto step = rowStep - 1; step < rowStep + 2; step++)
                 {
-                    callback(LifeOperation(step, Operation::Evaluate));
+                    callback(LifeOperation(layout.ToStorage(step), Operation::Evaluate));
                 }
             }
         }
@@ -16,5 +16,11 @@ namespace embeddedpenguins::life::infrastructure
         {
             
         }
+
+        // Evaluations and propagations are costed separately by the cost-weighted partitioner.
+        unsigned int CostClass() const { return static_cast<unsigned int>(Op); }
+
+        // Duplicate evaluations or propagations of a cell do the same thing, so keep just one.
+        bool Combine(const LifeOperation& other) { return other.Op == Op; }
     };
 }
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <sstream>
+#include <tuple>
 
 #include "LifeCommon.h"
 #include "LifeNode.h"
@@ -30,6 +31,14 @@ namespace embeddedpenguins::life::infrastructure
         {
         }
 
+        //
+        // The columns of the binary record format, starting with the index.
+        //
+        static constexpr auto Columns()
+        {
+            return std::make_tuple(&LifeRecord::LifeIndex, &LifeRecord::Type, &LifeRecord::Alive);
+        }
+
         static const string Header()
         {
             ostringstream header;
@@ -2,11 +2,13 @@
 
 #include <iostream>
 #include <vector>
+#include <string>
 
 #include "nlohmann/json.hpp"
 
 #include "ConfigurationRepository.h"
 #include "ProcessCallback.h"
+#include "IndexLayout.h"
 
 #include "LifeOperation.h"
 #include "LifeModelCarrier.h"
@@ -16,11 +18,14 @@ namespace embeddedpenguins::life::infrastructure
 {
     using std::cout;
     using std::vector;
+    using std::string;
 
     using nlohmann::json;
 
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
     using embeddedpenguins::modelengine::threads::ProcessCallback;
+    using embeddedpenguins::modelengine::IndexLayout;
+    using embeddedpenguins::modelengine::IndexOrder;
 
     class LifeSupport
     {
@@ -30,9 +35,11 @@ namespace embeddedpenguins::life::infrastructure
         unsigned long int width_ { 100 };
         unsigned long int height_ { 100 };
         unsigned long long int maxIndex_ { };
+        IndexLayout layout_ { };
 
     public:
         LifeModelCarrier& Model() { return modelCarrier_; }
+        const IndexLayout& Layout() const { return layout_; }
         const ConfigurationRepository& Configuration() const { return configuration_; }
 
     public:
@@ -51,6 +58,17 @@ namespace embeddedpenguins::life::infrastructure
                     height_ = dimensionArray[1];
                 }
             }
+
+            // Cells may be stored along a curve rather than row by row, to keep neighbours together.
+            auto indexOrder { IndexOrder::RowMajor };
+            if (!modelJson.is_null() && modelJson.contains("IndexLayout"))
+            {
+                const json& indexLayoutJson = modelJson["IndexLayout"];
+                if (indexLayoutJson.is_string())
+                    IndexLayout::ParseIndexOrder(indexLayoutJson.get<string>(), indexOrder);
+            }
+
+            layout_ = IndexLayout(width_, height_, indexOrder);
         }
 
         const unsigned long int Width() const { return width_; }
@@ -88,11 +106,15 @@ namespace embeddedpenguins::life::infrastructure
             initializedCells.push_back(centerCell + (width_ * 2));
         }
 
+        //
+        // Initial cells are given by grid index (row * width + column),
+        // and translated to where the layout stores them.
+        //
         void InitializeCells(vector<unsigned long long int>& initializedCells)
         {
             for (auto cellIndex : initializedCells)
             {
-                modelCarrier_.Model[cellIndex].Alive = true;
+                modelCarrier_.Model[layout_.ToStorage(cellIndex)].Alive = true;
             }
         }
 
@@ -100,17 +122,18 @@ namespace embeddedpenguins::life::infrastructure
         {
             for (auto cellIndex : initializedCells)
             {
-                SignalAllSurroundingCellsToEvaluate(cellIndex, callback);
+                SignalAllSurroundingCellsToEvaluate(layout_.ToStorage(cellIndex), callback);
             }
         }
 
         void SignalAllSurroundingCellsToEvaluate(unsigned long long int cellIndex, ProcessCallback<LifeOperation, LifeRecord>& callback)
         {
-            for (auto rowStep = cellIndex - width_; rowStep < cellIndex + width_ + 1; rowStep += width_)
+            auto gridIndex = layout_.ToGrid(cellIndex);
+            for (auto rowStep = gridIndex - width_; rowStep < gridIndex + width_ + 1; rowStep += width_)
             {
                 for (auto step = rowStep - 1; step < rowStep + 2; step++)
                 {
-                    callback(LifeOperation(step, Operation::Evaluate));
+                    callback(LifeOperation(layout_.ToStorage(step), Operation::Evaluate));
                 }
             }
         }
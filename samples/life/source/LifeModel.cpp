@@ -51,8 +51,8 @@ unsigned long int height { 100 };
 unsigned long int centerWidth {};
 unsigned long int centerHeight {};
 
-char PrintAndListenForQuit(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeModelCarrier& carrier);
-void PrintLifeScan(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeModelCarrier& carrier);
+char PrintAndListenForQuit(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeSupport& helper);
+void PrintLifeScan(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeSupport& helper);
 void ParseArguments(int argc, char* argv[]);
 
 ///////////////////////////////////////////////////////////////////////////
@@ -84,13 +84,13 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    PrintAndListenForQuit(modelRunner, carrier);
+    PrintAndListenForQuit(modelRunner, helper);
 
     modelRunner.WaitForQuit();
     return 0;
 }
 
-char PrintAndListenForQuit(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeModelCarrier& carrier)
+char PrintAndListenForQuit(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeSupport& helper)
 {
     constexpr char KEY_UP = 'A';
     constexpr char KEY_DOWN = 'B';
@@ -104,7 +104,7 @@ char PrintAndListenForQuit(ModelRunner<LifeOperation, LifeImplementation, LifeSu
         bool quit {false};
         while (!quit)
         {
-            if (displayOn) PrintLifeScan(modelRunner, carrier);
+            if (displayOn) PrintLifeScan(modelRunner, helper);
             auto gotChar = listener.Listen(50'000, c);
             if (gotChar)
             {
@@ -159,33 +159,36 @@ char PrintAndListenForQuit(ModelRunner<LifeOperation, LifeImplementation, LifeSu
     return c;
 }
 
-void PrintLifeScan(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeModelCarrier& carrier)
+void PrintLifeScan(ModelRunner<LifeOperation, LifeImplementation, LifeSupport, LifeRecord>& modelRunner, LifeSupport& helper)
 {
     constexpr int windowWidth = 100;
     constexpr int windowHeight = 30;
 
     cout << cls;
 
-    auto node = begin(carrier.Model);
-    std::advance(node, ((width * (centerHeight - (windowHeight / 2))) + centerWidth - (windowWidth / 2)));
+    // Walk the window on the grid, and find each cell where the layout stores it.
+    auto& model = helper.Model().Model;
+    auto& layout = helper.Layout();
+    auto rowStart = (width * (centerHeight - (windowHeight / 2))) + centerWidth - (windowWidth / 2);
     for (auto high = windowHeight; high; --high)
     {
-        for (auto wide = windowWidth; wide; --wide)
+        for (auto wide = 0; wide < windowWidth; wide++)
         {
-            cout << (node->Alive ? "*" : " ");
-            node++;
+            auto gridIndex = (rowStart + wide) % model.size();
+            cout << (model[layout.ToStorage(gridIndex)].Alive ? "*" : " ");
         }
         cout << '\n';
 
-        std::advance(node, width - windowWidth);
-        if (node >= end(carrier.Model)) node = begin(carrier.Model);
+        rowStart = (rowStart + width) % model.size();
     }
 
+    auto telemetry = modelRunner.GetModelEngine().GetTelemetry();
     cout
         << "(" << centerWidth << "," << centerHeight << ") "
         << " Tick: " << modelRunner.EnginePeriod().count() << " us "
-        << "Iterations: " << modelRunner.GetModelEngine().GetIterations() 
-        << "  Total work: " << modelRunner.GetModelEngine().GetTotalWork() 
+        << "Iterations: " << telemetry.Engine.Tick 
+        << "  Total work: " << telemetry.Engine.TotalWork 
+        << "  Imbalance: " << telemetry.Engine.LoadImbalance 
         << "                 \n";
 
     cout << "Arrow keys to navigate       + and - keys control speed            q to quit\n";
@@ -0,0 +1,38 @@
+#include <string>
+#include <iostream>
+
+#include "BinaryRecordFormat.h"
+
+#include "LifeRecord.h"
+
+using std::cout;
+using std::string;
+
+using embeddedpenguins::modelengine::BinaryRecordFormat;
+
+using embeddedpenguins::life::infrastructure::LifeRecord;
+
+///////////////////////////////////////////////////////////////////////////
+//Main program entry.
+//Convert a binary record file of the life model to CSV.
+//
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <binary record file> [<csv file>]\n";
+        return 1;
+    }
+
+    string binaryPath { argv[1] };
+    string csvPath { argc > 2 ? argv[2] : binaryPath.substr(0, binaryPath.rfind(".rec")) + ".csv" };
+
+    if (!BinaryRecordFormat<LifeRecord>::ConvertToCsv(binaryPath, csvPath))
+    {
+        cout << "Unable to convert " << binaryPath << " to " << csvPath << '\n';
+        return 1;
+    }
+
+    cout << "Converted " << binaryPath << " to " << csvPath << '\n';
+    return 0;
+}
@@ -11,8 +11,8 @@
 #include "WorkerThread.h"
 #include "WorkItem.h"
 #include "ProcessCallback.h"
-#include "Recorder.h"
-#include "Log.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
 
 #include "ParticleCommon.h"
 #include "ParticleSupport.h"
@@ -35,8 +35,8 @@ namespace embeddedpenguins::particle::infrastructure
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
     using ::embeddedpenguins::modelengine::threads::WorkerThread;
     using ::embeddedpenguins::modelengine::threads::ProcessCallback;
-    using embeddedpenguins::core::neuron::model::Log;
-    using embeddedpenguins::core::neuron::model::Recorder;
+    using embeddedpenguins::modelengine::AsyncLog;
+    using embeddedpenguins::modelengine::StreamingRecorder;
     using ::embeddedpenguins::modelengine::WorkItem;
 
     //
@@ -88,7 +88,7 @@ namespace embeddedpenguins::particle::infrastructure
         // here each tick to provide new input from external to the model.
         // It is up to the implementation to connect to the external source.
         //
-        void StreamNewInputWork(Log& log, Recorder<ParticleRecord>& record, 
+        void StreamNewInputWork(AsyncLog& log, StreamingRecorder<ParticleRecord>& record, 
             unsigned long long int tickNow, 
             ProcessCallback<ParticleOperation, ParticleRecord>& callback)
         {
@@ -109,7 +109,7 @@ namespace embeddedpenguins::particle::infrastructure
         // Process the work items described by the iterators in whatever
         // manner is appropriate to the model.
         //
-        void Process(Log& log, Recorder<ParticleRecord>& record, 
+        void Process(AsyncLog& log, StreamingRecorder<ParticleRecord>& record, 
             unsigned long long int tickNow, 
             typename vector<WorkItem<ParticleOperation>>::iterator begin, 
             typename vector<WorkItem<ParticleOperation>>::iterator end, 
@@ -158,7 +158,7 @@ namespace embeddedpenguins::particle::infrastructure
             }
         }
 
-        void ProcessWorkItem(Log& log, Recorder<ParticleRecord>& record, 
+        void ProcessWorkItem(AsyncLog& log, StreamingRecorder<ParticleRecord>& record, 
             unsigned long long int tickNow, 
             const ParticleOperation& work, 
             ProcessCallback<ParticleOperation, ParticleRecord>& callback)
@@ -185,7 +185,7 @@ namespace embeddedpenguins::particle::infrastructure
         // Pass the advanced parameters on to a new landing operation at the
         // index of the new position.  Vacate this index afterward.
         //
-        void ProcessPropagation(Log& log, Recorder<ParticleRecord>& record, 
+        void ProcessPropagation(AsyncLog& log, StreamingRecorder<ParticleRecord>& record, 
             const string& name,
             unsigned long long int index, 
             ProcessCallback<ParticleOperation, ParticleRecord>& callback)
@@ -194,12 +194,11 @@ namespace embeddedpenguins::particle::infrastructure
 
             auto [nextIndex, nextVerticalVector, nextHorizontalVector] = NewPositionAndVelocity(log, record, index, particleNode.VerticalVector, particleNode.HorizontalVector, particleNode.Gradient, callback);
 
-            record.Record(ParticleRecord(name, ParticleRecordType::Land, nextIndex, particleNode));
+            record.Record(ParticleRecord(name, ParticleRecordType::Land, helper_.Layout().ToGrid(nextIndex), particleNode));
             callback(ParticleOperation(nextIndex, name, nextVerticalVector, nextHorizontalVector, particleNode.Gradient, particleNode.Mass, particleNode.Speed, particleNode.Type));
 
 #ifndef NOLOG
-            log.Logger() << '<' << name << "> " << "Particle propagating from (" << particleNode.Name << ") index " << index << "\n";
-            log.Logit();
+            log.Write("<{}> Particle propagating from ({}) index {}\n", name, particleNode.Name, index);
 #endif
             memset(particleNode.Name, '\0', sizeof(particleNode.Name));
             particleNode.Occupied = false;
@@ -211,7 +210,7 @@ namespace embeddedpenguins::particle::infrastructure
         // the collision by reversing the vector of the incoming particle as if
         // the original occupant of the index were an immovable object.
         //
-        void ProcessLanding(Log& log, Recorder<ParticleRecord>& record, 
+        void ProcessLanding(AsyncLog& log, StreamingRecorder<ParticleRecord>& record, 
             unsigned long long int index, 
             const string& name,
             int verticalVector,
@@ -232,8 +231,7 @@ namespace embeddedpenguins::particle::infrastructure
                 auto [nextIndex, nextVerticalVector, nextHorizontalVector] = NewPositionAndVelocity(log, record, index, verticalVector, horizontalVector, particleNode.Gradient, callback);
 
 #ifndef NOLOG
-                log.Logger() << '<' << name << "> " << "Particle collision at index " << index << " already occupied by <" << particleNode.Name << ">\n";
-                log.Logit();
+                log.Write("<{}> Particle collision at index {} already occupied by <{}>\n", name, index, particleNode.Name);
 #endif
                 callback(ParticleOperation(nextIndex, name, nextVerticalVector, nextHorizontalVector, gradient, mass, speed, type));
                 return;
@@ -250,10 +248,9 @@ namespace embeddedpenguins::particle::infrastructure
             particleNode.Type = type;
 
 #ifndef NOLOG
-            log.Logger() << '<' << particleNode.Name << "> " << "Particle landed at index " << index << "\n";
-            log.Logit();
+            log.Write("<{}> Particle landed at index {}\n", particleNode.Name, index);
 #endif
-            record.Record(ParticleRecord(name, ParticleRecordType::Propagate, index, particleNode));
+            record.Record(ParticleRecord(name, ParticleRecordType::Propagate, helper_.Layout().ToGrid(index), particleNode));
             callback(ParticleOperation(index, name), 10 - particleNode.Speed);
         }
 
@@ -261,8 +258,10 @@ namespace embeddedpenguins::particle::infrastructure
         // Given a particle's index and vector, advance to the index of the
         // next particle position, taking into account 'boucing' off the
         // edges of the simulation as if they were perfectly elastic walls.
+        // Positions are worked out on the grid, and translated to and from
+        // where the layout stores them.
         //
-        tuple<unsigned long long int, int, int> NewPositionAndVelocity(Log& log, Recorder<ParticleRecord>& record, 
+        tuple<unsigned long long int, int, int> NewPositionAndVelocity(AsyncLog& log, StreamingRecorder<ParticleRecord>& record, 
             unsigned long long int index, 
             int verticalVector,
             int horizontalVector,
@@ -272,7 +271,7 @@ namespace embeddedpenguins::particle::infrastructure
             // NOTE - stay away from mixed signed/unsigned comparisons by casting everything signed.
             int width = (int)width_;
             int height = (int)height_;
-            long long int currentIndex = (long long int)index;
+            long long int currentIndex = (long long int)helper_.Layout().ToGrid(index);
 
             auto [horizontalStep, verticalStep] = DoBresenhamAlgorithm(verticalVector, horizontalVector, gradient);
 
@@ -304,7 +303,7 @@ namespace embeddedpenguins::particle::infrastructure
                 nextHorizontalVector *= -1;
             }
 
-            auto nextIndex = (unsigned long long int)nextVerticalPosition * width_ + (unsigned long long int)nextHorizontalPosition;
+            auto nextIndex = helper_.Layout().ToStorage((unsigned long long int)nextVerticalPosition, (unsigned long long int)nextHorizontalPosition);
 
             return make_tuple(nextIndex, nextVerticalVector, nextHorizontalVector);
         }
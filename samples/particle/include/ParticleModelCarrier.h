@@ -2,15 +2,17 @@
 
 #include <vector>
 
+#include "HugePageAllocator.h"
 #include "ParticleNode.h"
 
 namespace embeddedpenguins::particle::infrastructure
 {
     using std::vector;
+    using embeddedpenguins::modelengine::ModelVector;
 
     struct ParticleModelCarrier
     {
-        vector<ParticleNode>& Model;
+        ModelVector<ParticleNode>& Model;
         unsigned long int ModelSize() { return Model.size(); }
         bool Valid { true };
     };
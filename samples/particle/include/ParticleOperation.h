@@ -62,5 +62,8 @@ namespace embeddedpenguins::particle::infrastructure
             memset(Name, '\0', sizeof(Name));
             memcpy(Name, name.c_str(), (name.length() < 19 ? name.length() : 19));
         }
+
+        // Propagations and landings are costed separately by the cost-weighted partitioner.
+        unsigned int CostClass() const { return static_cast<unsigned int>(Op); }
     };
 }
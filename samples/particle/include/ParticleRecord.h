@@ -3,6 +3,7 @@
 #include <string>
 #include <cstring>
 #include <sstream>
+#include <tuple>
 
 #include "ParticleCommon.h"
 #include "ParticleNode.h"
@@ -60,6 +61,15 @@ namespace embeddedpenguins::particle::infrastructure
             memcpy(Name, name.c_str(), (name.length() < 19 ? name.length() : 19));
         }
 
+        //
+        // The columns of the binary record format, starting with the index.
+        //
+        static constexpr auto Columns()
+        {
+            return std::make_tuple(&ParticleRecord::ParticleIndex, &ParticleRecord::Name, &ParticleRecord::Type, 
+                &ParticleRecord::VerticalVector, &ParticleRecord::HorizontalVector, &ParticleRecord::Mass, &ParticleRecord::Speed);
+        }
+
         static const string Header()
         {
             ostringstream header;
@@ -9,6 +9,7 @@
 
 #include "ConfigurationRepository.h"
 #include "ProcessCallback.h"
+#include "IndexLayout.h"
 
 #include "ParticleCommon.h"
 #include "ParticleNode.h"
@@ -28,6 +29,8 @@ namespace embeddedpenguins::particle::infrastructure
 
     using embeddedpenguins::core::neuron::model::ConfigurationRepository;
     using embeddedpenguins::modelengine::threads::ProcessCallback;
+    using embeddedpenguins::modelengine::IndexLayout;
+    using embeddedpenguins::modelengine::IndexOrder;
 
     class ParticleSupport
     {
@@ -37,6 +40,7 @@ namespace embeddedpenguins::particle::infrastructure
         unsigned long int width_ { 100 };
         unsigned long int height_ { 100 };
         unsigned long long int maxIndex_ { };
+        IndexLayout layout_ { };
 
         vector<unsigned long long int> initializedCells_ {};
 
@@ -44,6 +48,7 @@ namespace embeddedpenguins::particle::infrastructure
         const unsigned long int Width() const { return width_; }
         const unsigned long int Height() const { return height_; }
         ParticleModelCarrier& Model() { return modelCarrier_; }
+        const IndexLayout& Layout() const { return layout_; }
         const ConfigurationRepository& Configuration() const { return configuration_; }
 
     public:
@@ -58,6 +63,18 @@ namespace embeddedpenguins::particle::infrastructure
                 width_ = dimensionArray[0];
                 height_ = dimensionArray[1];
             }
+
+            // Cells may be stored along a curve rather than row by row, to keep neighbours together.
+            auto indexOrder { IndexOrder::RowMajor };
+            const json& modelJson = configuration_.Configuration()["Model"];
+            if (!modelJson.is_null() && modelJson.contains("IndexLayout"))
+            {
+                const json& indexLayoutJson = modelJson["IndexLayout"];
+                if (indexLayoutJson.is_string())
+                    IndexLayout::ParseIndexOrder(indexLayoutJson.get<string>(), indexOrder);
+            }
+
+            layout_ = IndexLayout(width_, height_, indexOrder);
         }
 
         bool AllocateModel(unsigned long int modelSize = 0)
@@ -96,7 +113,7 @@ namespace embeddedpenguins::particle::infrastructure
 
         void InitializeCell(const string& name, unsigned long int row, unsigned long int column, int horizontalVector, int verticalVector, int mass, int speed, ParticleType type)
         {
-            auto index = row * width_ + column;
+            auto index = layout_.ToStorage(row, column);
             auto& particleNode = modelCarrier_.Model[index];
 
             memset(particleNode.Name, '\0', sizeof(particleNode.Name));
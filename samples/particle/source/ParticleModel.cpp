@@ -36,6 +36,7 @@ using nlohmann::json;
 
 using embeddedpenguins::modelengine::ModelEngine;
 using embeddedpenguins::modelengine::sdk::ModelRunner;
+using embeddedpenguins::modelengine::ModelVector;
 
 using embeddedpenguins::particle::infrastructure::ParticleOperation;
 using embeddedpenguins::particle::infrastructure::ParticleImplementation;
@@ -55,8 +56,8 @@ unsigned long int height { 100 };
 unsigned long int centerWidth {};
 unsigned long int centerHeight {};
 
-char PrintAndListenForQuit(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleModelCarrier& carrier);
-void PrintLifeScan(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleModelCarrier& carrier);
+char PrintAndListenForQuit(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleSupport& helper);
+void PrintLifeScan(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleSupport& helper);
 void ParseArguments(int argc, char* argv[]);
 
 ///////////////////////////////////////////////////////////////////////////
@@ -66,7 +67,7 @@ void ParseArguments(int argc, char* argv[]);
 int main(int argc, char* argv[])
 {
     ParseArguments(argc, argv);
-    vector<ParticleNode> model;
+    ModelVector<ParticleNode> model;
     ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord> modelRunner(argc, argv);
     ParticleModelCarrier carrier { .Model = model };
     ParticleSupport helper(carrier, modelRunner.ConfigurationCarrier());
@@ -88,13 +89,13 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    PrintAndListenForQuit(modelRunner, carrier);
+    PrintAndListenForQuit(modelRunner, helper);
 
     modelRunner.WaitForQuit();
     return 0;
 }
 
-char PrintAndListenForQuit(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleModelCarrier& carrier)
+char PrintAndListenForQuit(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleSupport& helper)
 {
     constexpr char KEY_UP = 'A';
     constexpr char KEY_DOWN = 'B';
@@ -108,7 +109,7 @@ char PrintAndListenForQuit(ModelRunner<ParticleOperation, ParticleImplementation
         bool quit {false};
         while (!quit)
         {
-            if (displayOn) PrintLifeScan(modelRunner, carrier);
+            if (displayOn) PrintLifeScan(modelRunner, helper);
             auto gotChar = listener.Listen(50'000, c);
             if (gotChar)
             {
@@ -163,27 +164,30 @@ char PrintAndListenForQuit(ModelRunner<ParticleOperation, ParticleImplementation
     return c;
 }
 
-void PrintLifeScan(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleModelCarrier& carrier)
+void PrintLifeScan(ModelRunner<ParticleOperation, ParticleImplementation, ParticleSupport, ParticleRecord>& modelRunner, ParticleSupport& helper)
 {
     constexpr int windowWidth = 100;
     constexpr int windowHeight = 30;
 
-    auto occupancy = std::count_if(carrier.Model.begin(), carrier.Model.end(), 
+    auto& model = helper.Model().Model;
+    auto& layout = helper.Layout();
+    auto occupancy = std::count_if(model.begin(), model.end(), 
         [](const ParticleNode& node){ return node.Occupied; });
 
     cout << cls;
 
-    auto node = begin(carrier.Model);
     if (centerHeight < windowHeight / 2) centerHeight = windowHeight / 2;
     if (centerHeight >= height - (windowHeight / 2)) centerHeight = height - (windowHeight / 2) - 1;
     if (centerWidth < windowWidth / 2) centerWidth = windowWidth / 2;
     if (centerWidth >= width - (windowWidth / 2)) centerWidth = width - (windowWidth / 2) - 1;
 
-    std::advance(node, ((width * (centerHeight - (windowHeight / 2))) + centerWidth - (windowWidth / 2)));
+    // Walk the window on the grid, and find each cell where the layout stores it.
+    auto rowStart = (width * (centerHeight - (windowHeight / 2))) + centerWidth - (windowWidth / 2);
     for (auto high = windowHeight; high; --high)
     {
-        for (auto wide = windowWidth; wide; --wide)
+        for (auto wide = 0; wide < windowWidth; wide++)
         {
+            auto node = begin(model) + layout.ToStorage((rowStart + wide) % model.size());
             if (!node->Occupied) cout << ' ';
             else
             {
@@ -197,19 +201,19 @@ void PrintLifeScan(ModelRunner<ParticleOperation, ParticleImplementation, Partic
                 default: cout << '-'; break;
                 }
             }
-            node++;
         }
         cout << '\n';
 
-        std::advance(node, width - windowWidth);
-        if (node >= end(carrier.Model)) node = begin(carrier.Model);
+        rowStart = (rowStart + width) % model.size();
     }
 
+    auto telemetry = modelRunner.GetModelEngine().GetTelemetry();
     cout
         <<  occupancy << ":(" << centerWidth << "," << centerHeight << ") "
         << " Tick: " << modelRunner.EnginePeriod().count() << " us "
-        << "Iterations: " << modelRunner.GetModelEngine().GetIterations() 
-        << "  Total work: " << modelRunner.GetModelEngine().GetTotalWork() 
+        << "Iterations: " << telemetry.Engine.Tick 
+        << "  Total work: " << telemetry.Engine.TotalWork 
+        << "  Imbalance: " << telemetry.Engine.LoadImbalance 
         << "                 \n";
 
     cout << "Arrow keys to navigate       + and - keys control speed            q to quit\n";
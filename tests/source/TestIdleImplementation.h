@@ -9,7 +9,8 @@
 #include "WorkerThread.h"
 #include "WorkItem.h"
 #include "ProcessCallback.h"
-#include "Recorder.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
 #include "TestOperation.h"
 #include "TestNode.h"
 #include "TestModelCarrier.h"
@@ -26,9 +27,9 @@ namespace test::embeddedpenguins::modelengine::infrastructure
     using time_point = std::chrono::high_resolution_clock::time_point;
 
     using ::embeddedpenguins::core::neuron::model::ConfigurationRepository;
-    using ::embeddedpenguins::core::neuron::model::Log;
+    using ::embeddedpenguins::modelengine::AsyncLog;
     using ::embeddedpenguins::core::neuron::model::LogLevel;
-    using ::embeddedpenguins::core::neuron::model::Recorder;
+    using ::embeddedpenguins::modelengine::StreamingRecorder;
 
     using ::embeddedpenguins::modelengine::threads::WorkerThread;
     using ::embeddedpenguins::modelengine::threads::ProcessCallback;
@@ -62,7 +63,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
             
         }
 
-        void StreamNewInputWork(Log& log, Recorder<TestRecord>& record, 
+        void StreamNewInputWork(AsyncLog& log, StreamingRecorder<TestRecord>& record, 
             unsigned long long int ticksSinceEpoch, 
             ProcessCallback<TestOperation, TestRecord>& callback)
         {
@@ -72,7 +73,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         }
 
         // Process but add no new work.  After the first single work item, the whole model will be idle.
-        void Process(Log& log, Recorder<TestRecord>& record, 
+        void Process(AsyncLog& log, StreamingRecorder<TestRecord>& record, 
             unsigned long long int ticksSinceEpoch, 
             typename vector<WorkItem<TestOperation>>::iterator begin, 
             typename vector<WorkItem<TestOperation>>::iterator end, 
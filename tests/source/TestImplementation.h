@@ -9,7 +9,8 @@
 #include "WorkerThread.h"
 #include "WorkItem.h"
 #include "ProcessCallback.h"
-#include "Recorder.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
 #include "TestOperation.h"
 #include "TestNode.h"
 #include "TestModelCarrier.h"
@@ -28,8 +29,8 @@ namespace test::embeddedpenguins::modelengine::infrastructure
     using ::embeddedpenguins::core::neuron::model::ConfigurationRepository;
     using ::embeddedpenguins::modelengine::threads::WorkerThread;
     using ::embeddedpenguins::modelengine::threads::ProcessCallback;
-    using ::embeddedpenguins::core::neuron::model::Log;
-    using ::embeddedpenguins::core::neuron::model::Recorder;
+    using ::embeddedpenguins::modelengine::AsyncLog;
+    using ::embeddedpenguins::modelengine::StreamingRecorder;
     using ::embeddedpenguins::modelengine::WorkItem;
 
     // Note: the callback should be allowed to be declared something like
@@ -60,21 +61,20 @@ namespace test::embeddedpenguins::modelengine::infrastructure
             
         }
 
-        void StreamNewInputWork(Log& log, Recorder<TestRecord>& record, 
+        void StreamNewInputWork(AsyncLog& log, StreamingRecorder<TestRecord>& record, 
                         unsigned long long int tickNow, 
                         ProcessCallback<TestOperation, TestRecord>& callback)
         {
             if (firstRun_)
             {
                 callback(TestOperation(1));
-                log.Logger() << "Creating initial work for index " << 1 << " with tick " << tickNow + 1 << '\n';
-                log.Logit();
+                log.Write("Creating initial work for index {} with tick {}\n", 1, tickNow + 1);
             }
 
             firstRun_ = false;
         }
 
-        void Process(Log& log, Recorder<TestRecord>& record, 
+        void Process(AsyncLog& log, StreamingRecorder<TestRecord>& record, 
                     unsigned long long int tickNow, 
                     typename vector<WorkItem<TestOperation>>::iterator begin, 
                     typename vector<WorkItem<TestOperation>>::iterator end, 
@@ -86,8 +86,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
             for (auto& work = begin; work != end; work++)
             {
                 helper_.Model().Model[work->Operator.Index].Data += workerId_;
-                log.Logger() << "(" << work->Tick << ") Index " << work->Operator.Index << " set to " << helper_.Model().Model[work->Operator.Index].Data << " in tick " << tickNow << '\n';
-                log.Logit();
+                log.Write("({}) Index {} set to {} in tick {}\n", work->Tick, work->Operator.Index, helper_.Model().Model[work->Operator.Index].Data, tickNow);
             }
 
             auto span = helper_.Model().ModelSize() / 7;
@@ -95,12 +94,10 @@ namespace test::embeddedpenguins::modelengine::infrastructure
             for (auto _ = 6; _--; index += span)
             {
                 callback(TestOperation(index));
-                log.Logger() << "Creating work for index " << index << " with tick " << tickNow + 1 << '\n';
-                log.Logit();
+                log.Write("Creating work for index {} with tick {}\n", index, tickNow + 1);
             }
             callback(TestOperation(helper_.Model().ModelSize() - 1));
-            log.Logger() << "Creating work for index " << helper_.Model().ModelSize() - 1 << " with tick " << tickNow + 1 << '\n';
-            log.Logit();
+            log.Write("Creating work for index {} with tick {}\n", helper_.Model().ModelSize() - 1, tickNow + 1);
         }
     };
 }
@@ -9,4 +9,24 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         TestOperation() = default;
         TestOperation(long long int index) : Index(index) { }
     };
+
+    //
+    // An operation that sums the inputs to a node, kept apart by kind.
+    //
+    struct TestCombiningOperation
+    {
+        long long int Index {0};
+        int Kind {0};
+        int Input {0};
+
+        TestCombiningOperation() = default;
+        TestCombiningOperation(long long int index, int kind, int input) : Index(index), Kind(kind), Input(input) { }
+
+        bool Combine(const TestCombiningOperation& other)
+        {
+            if (other.Kind != Kind) return false;
+            Input += other.Input;
+            return true;
+        }
+    };
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <tuple>
 
 namespace test::embeddedpenguins::modelengine::infrastructure
 {
@@ -27,4 +28,36 @@ namespace test::embeddedpenguins::modelengine::infrastructure
             return row_;
         }
     };
+
+    //
+    // A record with columns for the binary record format.
+    //
+    struct TestColumnRecord
+    {
+        unsigned long long int Index { };
+        int Value { };
+        char Tag[3] { };
+
+        TestColumnRecord(unsigned long long int index, int value) :
+            Index(index),
+            Value(value),
+            Tag { 't', static_cast<char>('0' + value % 10), '\0' }
+        {
+        }
+
+        static constexpr auto Columns()
+        {
+            return std::make_tuple(&TestColumnRecord::Index, &TestColumnRecord::Value, &TestColumnRecord::Tag);
+        }
+
+        static const string Header()
+        {
+            return string("index,value,tag");
+        }
+
+        const string Format()
+        {
+            return std::to_string(Index) + "," + std::to_string(Value) + "," + Tag;
+        }
+    };
 }
@@ -1,4 +1,11 @@
 #include <chrono>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <cstdio>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
@@ -6,8 +13,23 @@
 #include "Log.h"
 #include "WorkerContext.h"
 #include "ProcessCallback.h"
+#include "WorkItemSorter.h"
+#include "DenseFrontier.h"
+#include "TickBarrier.h"
+#include "TimingWheel.h"
+#include "ScratchArena.h"
+#include "CpuPlacement.h"
+#include "FirstTouch.h"
+#include "HugePageAllocator.h"
+#include "DirtyBlockMap.h"
+#include "StreamingRecorder.h"
+#include "AsyncLog.h"
+#include "EngineTelemetry.h"
+#include "BinaryRecordFormat.h"
+#include "IndexLayout.h"
 #include "TestOperation.h"
 #include "TestRecord.h"
+#include "TestNode.h"
 
 namespace test::embeddedpenguins::modelengine::infrastructure
 {
@@ -16,9 +38,39 @@ namespace test::embeddedpenguins::modelengine::infrastructure
     using std::chrono::high_resolution_clock;
     using std::chrono::duration_cast;
     using std::chrono::time_point_cast;
+    using std::vector;
+    using std::string;
+    using std::thread;
 
     using ::embeddedpenguins::modelengine::threads::WorkerContext;
     using ::embeddedpenguins::modelengine::threads::ProcessCallback;
+    using ::embeddedpenguins::modelengine::WorkItem;
+    using ::embeddedpenguins::modelengine::WorkItemSorter;
+    using ::embeddedpenguins::modelengine::DenseFrontier;
+    using ::embeddedpenguins::modelengine::threads::TickBarrier;
+    using ::embeddedpenguins::modelengine::TimingWheel;
+    using ::embeddedpenguins::modelengine::threads::ScratchArena;
+    using ::embeddedpenguins::modelengine::threads::ArenaAllocator;
+    using ::embeddedpenguins::modelengine::threads::CpuPlacement;
+    using ::embeddedpenguins::modelengine::threads::FirstTouch;
+    using ::embeddedpenguins::modelengine::ModelVector;
+    using ::embeddedpenguins::modelengine::HugePageAdvisor;
+    using ::embeddedpenguins::modelengine::threads::DirtyBlockMap;
+    using ::embeddedpenguins::modelengine::StreamingRecorder;
+    using ::embeddedpenguins::modelengine::DefaultRecordBlockRecords;
+    using ::embeddedpenguins::modelengine::RecordWriter;
+    using ::embeddedpenguins::modelengine::RecordFormat;
+    using ::embeddedpenguins::modelengine::BinaryRecordFormat;
+    using ::embeddedpenguins::modelengine::RecordSettings;
+    using ::embeddedpenguins::modelengine::RecordMode;
+    using ::embeddedpenguins::modelengine::AsyncLog;
+    using ::embeddedpenguins::modelengine::LogSink;
+    using ::embeddedpenguins::modelengine::TelemetryChannel;
+    using ::embeddedpenguins::modelengine::EngineTelemetry;
+    using ::embeddedpenguins::modelengine::TickTelemetry;
+    using ::embeddedpenguins::modelengine::WorkerTelemetry;
+    using ::embeddedpenguins::modelengine::IndexLayout;
+    using ::embeddedpenguins::modelengine::IndexOrder;
     using ::embeddedpenguins::core::neuron::model::LogLevel;
 
     class WhenDoingSupportFunctions : public ::testing::Test
@@ -61,4 +113,648 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         auto actual = context.WorkForFutureTicks1[0].Tick;
         EXPECT_EQ(expected, actual);
     }
+
+    TEST_F(WhenDoingSupportFunctions, RadixSortGroupsWorkByIndexStably)
+    {
+        // arrange
+        constexpr unsigned long long int modelSize = 1'000'000;
+        vector<WorkItem<TestOperation>> work;
+        unsigned long long int index = 12345;
+        for (unsigned long long int order = 0; order < 20'000; order += 2)
+        {
+            // Tick records the original order, to check stability.
+            index = (index * 7919 + 104729) % modelSize;
+            work.push_back(WorkItem<TestOperation> { order, TestOperation(index) });
+            work.push_back(WorkItem<TestOperation> { order + 1, TestOperation(index % 1000) });
+        }
+        // Too little work for a radix sort, so the comparison sort is used.
+        vector<WorkItem<TestOperation>> smallWork;
+        for (unsigned long long int order = 0; order < 200; order++)
+            smallWork.push_back(WorkItem<TestOperation> { order, TestOperation((order * 7) % 5) });
+        WorkItemSorter<TestOperation> sorter;
+
+        // act
+        sorter.SortByIndex(work, modelSize);
+        sorter.SortByIndex(smallWork, modelSize);
+
+        // assert
+        ASSERT_EQ(work.size(), 20'000);
+        ASSERT_EQ(smallWork.size(), 200);
+        for (auto* sorted : { &work, &smallWork })
+        {
+            for (auto item = sorted->begin() + 1; item != sorted->end(); item++)
+            {
+                ASSERT_LE((item - 1)->Operator.Index, item->Operator.Index);
+                if ((item - 1)->Operator.Index == item->Operator.Index)
+                {
+                    EXPECT_LT((item - 1)->Tick, item->Tick);
+                }
+            }
+        }
+    }
+
+    TEST_F(WhenDoingSupportFunctions, MergedRunsKeepRunOrderForEachIndex)
+    {
+        // arrange
+        // Tick records the run, to check the order for each index.  The last run is empty.
+        vector<vector<WorkItem<TestOperation>>> runs(4);
+        for (unsigned long long int run = 0; run < 3; run++)
+            for (unsigned long long int index = run * 10; index < run * 10 + 30; index += 2)
+                runs[run].push_back(WorkItem<TestOperation> { run, TestOperation(index) });
+        vector<vector<WorkItem<TestOperation>>*> runPointers;
+        for (auto& run : runs)
+            runPointers.push_back(&run);
+        vector<WorkItem<TestOperation>> merged;
+        WorkItemSorter<TestOperation> sorter;
+
+        // act
+        sorter.MergeRuns(runPointers, merged);
+
+        // assert
+        ASSERT_EQ(merged.size(), 45);
+        for (auto item = merged.begin() + 1; item != merged.end(); item++)
+        {
+            ASSERT_LE((item - 1)->Operator.Index, item->Operator.Index);
+            if ((item - 1)->Operator.Index == item->Operator.Index)
+            {
+                EXPECT_LT((item - 1)->Tick, item->Tick);
+            }
+        }
+    }
+
+    TEST_F(WhenDoingSupportFunctions, CoalescingCombinesEachIndexOncePerKind)
+    {
+        // arrange
+        // A hub index takes most of the work, in two kinds interleaved.
+        vector<WorkItem<TestCombiningOperation>> work;
+        for (int input = 1; input <= 1000; input++)
+            work.push_back(WorkItem<TestCombiningOperation> { 1ULL, TestCombiningOperation(7, input % 2, input) });
+        for (int input = 1; input <= 10; input++)
+            work.push_back(WorkItem<TestCombiningOperation> { 1ULL, TestCombiningOperation(input * 3, 0, input) });
+        WorkItemSorter<TestCombiningOperation> sorter;
+        sorter.SortByIndex(work, 100);
+
+        vector<WorkItem<TestOperation>> plainWork { { 1ULL, TestOperation(2) }, { 1ULL, TestOperation(2) } };
+        WorkItemSorter<TestOperation> plainSorter;
+
+        // act
+        auto removed = sorter.Coalesce(work);
+        auto plainRemoved = plainSorter.Coalesce(plainWork);
+
+        // assert
+        EXPECT_EQ(removed, 1000 - 2);
+        ASSERT_EQ(work.size(), 12);
+        auto hubItems { 0 };
+        for (auto& item : work)
+        {
+            if (item.Operator.Index != 7) continue;
+            hubItems++;
+            EXPECT_EQ(item.Operator.Input, item.Operator.Kind == 0 ? 500 * 501 : 500 * 500);
+        }
+        EXPECT_EQ(hubItems, 2);
+        EXPECT_EQ(plainRemoved, 0);
+        EXPECT_EQ(plainWork.size(), 2);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, DenseFrontierReadsBackInIndexOrderAndClears)
+    {
+        // arrange
+        // Index 70 gets two kinds of work, so one of them overflows; 500 is past the model.
+        DenseFrontier<TestCombiningOperation> frontier;
+        WorkItemSorter<TestCombiningOperation> sorter;
+        frontier.Resize(200);
+        frontier.StartInserting();
+        vector<TestCombiningOperation> operations { { 150, 0, 1 }, { 70, 1, 1 }, { 3, 0, 1 }, { 70, 1, 1 }, { 500, 0, 1 }, { 70, 0, 1 }, { 130, 0, 1 } };
+        for (auto& operation : operations)
+            frontier.Insert(WorkItem<TestCombiningOperation> { 1ULL, operation }, true);
+        frontier.FinishInserting(sorter);
+
+        // act
+        vector<WorkItem<TestCombiningOperation>> copied;
+        frontier.CopyTo(copied);
+
+        vector<WorkItem<TestCombiningOperation>> batch;
+        vector<long long int> firstStripe;
+        vector<long long int> secondStripe;
+        frontier.ReadStripe(0ULL, 2ULL, true, batch, [&firstStripe](auto batchBegin, auto batchEnd) { for (auto item = batchBegin; item != batchEnd; item++) firstStripe.push_back(item->Operator.Index); });
+        frontier.ReadStripe(2ULL, frontier.WordCount(), true, batch, [&secondStripe](auto batchBegin, auto batchEnd) { for (auto item = batchBegin; item != batchEnd; item++) secondStripe.push_back(item->Operator.Index); });
+
+        // assert
+        EXPECT_EQ(frontier.Count(), 6);
+        ASSERT_EQ(copied.size(), 6);
+        EXPECT_EQ(copied[1].Operator.Index, 70);
+        EXPECT_EQ(copied[1].Operator.Input, 2);
+        EXPECT_EQ(copied[2].Operator.Index, 70);
+        EXPECT_EQ(copied[2].Operator.Input, 1);
+        EXPECT_EQ(firstStripe, (vector<long long int> { 3, 70, 70 }));
+        EXPECT_EQ(secondStripe, (vector<long long int> { 130, 150, 500 }));
+        for (auto word = 0ULL; word < frontier.WordCount(); word++)
+            EXPECT_EQ(frontier.ActiveInWord(word), 0);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, TickBarrierKeepsThreadsInStep)
+    {
+        // arrange
+        constexpr int passages = 2'000;
+        constexpr int threadCount = 3;
+        TickBarrier spinningBarrier(threadCount, 1'000);
+        TickBarrier parkingBarrier(threadCount, 0);
+        vector<int> phases(threadCount, 0);
+        std::atomic<bool> outOfStep { false };
+
+        // act
+        auto participant = [&](int id)
+        {
+            int spinningSense { 0 };
+            int parkingSense { 0 };
+            for (auto passage = 0; passage < passages; passage++)
+            {
+                phases[id] = passage;
+                auto& barrier = (passage % 2 == 0) ? spinningBarrier : parkingBarrier;
+                auto& sense = (passage % 2 == 0) ? spinningSense : parkingSense;
+                barrier.ArriveAndWait(sense);
+
+                for (auto phase : phases)
+                    if (phase != passage) outOfStep = true;
+
+                barrier.ArriveAndWait(sense);
+            }
+        };
+        vector<thread> threads;
+        for (auto id = 1; id < threadCount; id++)
+            threads.push_back(thread(participant, id));
+        participant(0);
+        for (auto& participantThread : threads)
+            participantThread.join();
+
+        // assert
+        EXPECT_FALSE(outOfStep);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, TimingWheelFindsEarliestTickAcrossLevels)
+    {
+        // arrange
+        TimingWheel<TestOperation> wheel;
+        vector<WorkItem<TestOperation>> dueWork;
+        wheel.Insert(WorkItem<TestOperation> { 300, TestOperation(1) });
+        wheel.ExtractDueWork(100, dueWork);
+        wheel.Insert(WorkItem<TestOperation> { 350, TestOperation(2) });
+        wheel.Insert(WorkItem<TestOperation> { 70'000, TestOperation(3) });
+
+        // Above level 0, the current slot holds only work for the next rotation.
+        TimingWheel<TestOperation> wrappedWheel;
+        vector<WorkItem<TestOperation>> wrappedDueWork;
+        wrappedWheel.ExtractDueWork(511, wrappedDueWork);
+        wrappedWheel.Insert(WorkItem<TestOperation> { 511 + 65'535, TestOperation(4) });
+        wrappedWheel.Insert(WorkItem<TestOperation> { 511 + 300, TestOperation(5) });
+
+        // act
+        auto earliestTick = wheel.EarliestTick();
+        wheel.ExtractDueWork(301, dueWork);
+        auto wrappedEarliestTick = wrappedWheel.EarliestTick();
+        wrappedWheel.ExtractDueWork(wrappedEarliestTick + 1, wrappedDueWork);
+
+        // assert
+        EXPECT_EQ(earliestTick, 300);
+        ASSERT_EQ(dueWork.size(), 1);
+        EXPECT_EQ(dueWork.front().Operator.Index, 1);
+        EXPECT_EQ(wheel.EarliestTick(), 350);
+        EXPECT_EQ(wrappedEarliestTick, 811);
+        ASSERT_EQ(wrappedDueWork.size(), 1);
+        EXPECT_EQ(wrappedDueWork.front().Operator.Index, 5);
+        EXPECT_EQ(wrappedWheel.EarliestTick(), 511 + 65'535);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, ScratchArenaSettlesIntoOneBlock)
+    {
+        // arrange
+        ScratchArena arena(1024);
+        auto fillScratch = [&arena]()
+        {
+            vector<unsigned long long int, ArenaAllocator<unsigned long long int>> scratch { ArenaAllocator<unsigned long long int>(arena) };
+            for (unsigned long long int value = 0; value < 10'000; value++)
+                scratch.push_back(value);
+            return scratch.back() == 9'999 && reinterpret_cast<size_t>(scratch.data()) % alignof(unsigned long long int) == 0;
+        };
+
+        // act
+        auto firstTickCorrect = fillScratch();
+        auto blocksAfterFirstTick = arena.BlockCount();
+        arena.Reset();
+        auto capacityAfterReset = arena.Capacity();
+        auto secondTickCorrect = fillScratch();
+        arena.Reset();
+
+        // assert
+        EXPECT_TRUE(firstTickCorrect);
+        EXPECT_TRUE(secondTickCorrect);
+        EXPECT_GT(blocksAfterFirstTick, 1);
+        EXPECT_EQ(arena.BlockCount(), 1);
+        EXPECT_EQ(arena.Capacity(), capacityAfterReset);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, CpuPlacementUsesOnlyAllowedCpus)
+    {
+        // arrange
+        auto allowedCpus = CpuPlacement::AllowedCpus();
+        vector<int> configuredCores { 100'000, allowedCpus.back(), allowedCpus.back() };
+
+        // act
+        auto usableCpus = CpuPlacement::UsableCpus(configuredCores, false);
+        auto parsedCpus = CpuPlacement::ParseCpuList("0-3,8,10-11\n");
+
+        // assert
+        ASSERT_FALSE(allowedCpus.empty());
+        ASSERT_EQ(usableCpus.size(), 1);
+        EXPECT_EQ(usableCpus.front(), allowedCpus.back());
+        EXPECT_EQ(parsedCpus, (vector<int> { 0, 1, 2, 3, 8, 10, 11 }));
+        EXPECT_EQ(CpuPlacement::CpuForThread(parsedCpus, 0), 0);
+        EXPECT_EQ(CpuPlacement::CpuForThread(parsedCpus, 9), 2);
+        EXPECT_EQ(CpuPlacement::CpuForThread(vector<int> { }, 1), -1);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, FirstTouchRebuildsEveryStripe)
+    {
+        // arrange
+        vector<TestNode> model(1'000'003);
+        for (auto& node : model) node.Data = 7;
+        vector<vector<int>> notTrivial(10, vector<int> { 7 });
+        vector<int> stripeCpus { -1, -1, -1, -1, -1 };
+
+        // act
+        auto spread = FirstTouch::SpreadModel(model, stripeCpus);
+        auto notTrivialSpread = FirstTouch::SpreadModel(notTrivial, stripeCpus);
+
+        // assert
+        EXPECT_TRUE(spread);
+        EXPECT_EQ(model.size(), 1'000'003);
+        EXPECT_TRUE(std::all_of(begin(model), end(model), [](const TestNode& node) { return node.Data == 0; }));
+        EXPECT_FALSE(notTrivialSpread);
+        EXPECT_EQ(notTrivial[9], vector<int> { 7 });
+    }
+
+    TEST_F(WhenDoingSupportFunctions, HugePageModelVectorBehavesLikeAVector)
+    {
+        // arrange
+        ModelVector<TestNode> model;
+        ModelVector<TestNode> smallModel(10);
+        vector<int> stripeCpus { -1, -1, -1 };
+        HugePageAdvisor advisor;
+        vector<WorkItem<TestOperation>> workBuffer;
+        workBuffer.reserve(200'000);
+
+        // act
+        model.resize(1'500'000);
+        for (auto index = 0; index < model.size(); index++) model[index].Data = index;
+        model.resize(3'000'000);
+        auto firstHalfKept = std::all_of(begin(model), begin(model) + 1'500'000, [&model](const TestNode& node) { return node.Data == &node - model.data(); });
+        auto spread = FirstTouch::SpreadModel(model, stripeCpus);
+        advisor.Advise(workBuffer);
+        advisor.Advise(workBuffer);
+
+        // assert
+        EXPECT_TRUE(firstHalfKept);
+        EXPECT_TRUE(spread);
+        EXPECT_TRUE(std::all_of(begin(model), end(model), [](const TestNode& node) { return node.Data == 0; }));
+        EXPECT_EQ(smallModel.size(), 10);
+        EXPECT_EQ(workBuffer.capacity(), 200'000);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, DirtyBlockMapTakesEachDirtyBlockOnce)
+    {
+        // arrange
+        DirtyBlockMap dirtyBlocks;
+        dirtyBlocks.Resize(10'000, sizeof(TestNode), 64 * sizeof(TestNode));
+        vector<unsigned long long int> firstBlocks;
+        vector<unsigned long long int> secondBlocks;
+
+        // act
+        for (auto index : { 9'999, 3, 0, 63, 64, 5'000, 5'001, 10'000 })
+            dirtyBlocks.Mark(index);
+        dirtyBlocks.TakeDirtyBlocks(firstBlocks);
+        dirtyBlocks.TakeDirtyBlocks(secondBlocks);
+
+        // assert
+        EXPECT_EQ(dirtyBlocks.BlockNodes(), 64);
+        EXPECT_EQ(dirtyBlocks.BlockCount(), 157);
+        EXPECT_EQ(firstBlocks, (vector<unsigned long long int> { 0, 1, 78, 156 }));
+        EXPECT_TRUE(secondBlocks.empty());
+    }
+
+    TEST_F(WhenDoingSupportFunctions, StreamingRecorderWritesEveryRecordInTheBackground)
+    {
+        // arrange
+        string recordFile { "WhenDoingSupportFunctions.records.csv" };
+        unsigned long long int ticks { 0ULL };
+        RecordWriter<TestRecord> writer;
+        StreamingRecorder<TestRecord> recorder(ticks);
+        auto opened = writer.Open(recordFile);
+        recorder.Attach(writer, 3);
+
+        // act
+        for (ticks = 0; ticks < 10; ticks++)
+        {
+            string row { std::to_string(ticks * 2) };
+            recorder.Record(TestRecord(row));
+        }
+        recorder.Flush();
+        writer.Close();
+
+        vector<string> lines;
+        std::ifstream file(recordFile);
+        for (string line; std::getline(file, line); )
+            lines.push_back(line);
+        std::remove(recordFile.c_str());
+
+        // assert
+        EXPECT_TRUE(opened);
+        EXPECT_FALSE(writer.Failed());
+        EXPECT_EQ(writer.RecordsWritten(), 10);
+        ASSERT_EQ(lines.size(), 11);
+        EXPECT_EQ(lines[0], "Tick," + TestRecord::Header());
+        EXPECT_EQ(lines[1], "0,0");
+        EXPECT_EQ(lines[10], "9,18");
+    }
+
+    TEST_F(WhenDoingSupportFunctions, StreamingRecorderWithoutAWriterStaysBounded)
+    {
+        // arrange
+        string recordFile { "WhenDoingSupportFunctions.unattached.csv" };
+        unsigned long long int ticks { 0ULL };
+        RecordWriter<TestRecord> writer;
+        StreamingRecorder<TestRecord> recorder(ticks);
+
+        // act
+        for (ticks = 0; ticks < DefaultRecordBlockRecords + 5; ticks++)
+        {
+            string row { std::to_string(ticks) };
+            recorder.Record(TestRecord(row));
+        }
+        auto opened = writer.Open(recordFile);
+        recorder.Attach(writer, 3);
+        recorder.Flush();
+        writer.Close();
+        std::remove(recordFile.c_str());
+
+        // assert
+        EXPECT_TRUE(opened);
+        EXPECT_EQ(writer.RecordsWritten(), 5);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, FlightRecorderKeepsOnlyTheLastSampledTicks)
+    {
+        // arrange
+        string recordFile { "WhenDoingSupportFunctions.ring.csv" };
+        unsigned long long int ticks { 0ULL };
+        RecordWriter<TestRecord> writer;
+        StreamingRecorder<TestRecord> recorder(ticks);
+        auto opened = writer.Open(recordFile);
+        RecordSettings settings {};
+        settings.Mode = RecordMode::Ring;
+        settings.RingRecords = 4;
+        settings.RingTicks = 6;
+        settings.EveryTicks = 2;
+        recorder.Attach(writer, settings);
+
+        // act
+        for (ticks = 0; ticks < 20; ticks++)
+        {
+            string row { std::to_string(ticks * 2) };
+            recorder.Record(TestRecord(row));
+        }
+        ticks = 19;
+        recorder.Dump();
+        recorder.Flush();
+        writer.Close();
+
+        vector<string> lines;
+        std::ifstream file(recordFile);
+        for (string line; std::getline(file, line); )
+            lines.push_back(line);
+        std::remove(recordFile.c_str());
+
+        // assert
+        EXPECT_TRUE(opened);
+        EXPECT_EQ(writer.RecordsWritten(), 3);
+        ASSERT_EQ(lines.size(), 4);
+        EXPECT_EQ(lines[1], "14,28");
+        EXPECT_EQ(lines[2], "16,32");
+        EXPECT_EQ(lines[3], "18,36");
+    }
+
+    TEST_F(WhenDoingSupportFunctions, IndexSamplingRecordsOnlyTheSampledNodes)
+    {
+        // arrange
+        string recordFile { "WhenDoingSupportFunctions.sampled.csv" };
+        unsigned long long int ticks { 0ULL };
+        RecordWriter<TestColumnRecord> writer;
+        StreamingRecorder<TestColumnRecord> recorder(ticks);
+        auto opened = writer.Open(recordFile);
+        RecordSettings settings {};
+        settings.IndexSample = 8;
+        recorder.Attach(writer, settings);
+        unsigned long long int sampled { 0ULL };
+
+        // act
+        for (auto index = 0ULL; index < 800; index++)
+        {
+            if (recorder.Samples(index)) sampled++;
+            recorder.Record(TestColumnRecord(index, 0));
+        }
+        recorder.Flush();
+        writer.Close();
+        std::remove(recordFile.c_str());
+
+        // assert
+        EXPECT_TRUE(opened);
+        EXPECT_EQ(writer.RecordsWritten(), sampled);
+        EXPECT_GT(sampled, 50);
+        EXPECT_LT(sampled, 150);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, AsyncLogFormatsEveryMessageInTheBackground)
+    {
+        // arrange
+        string logFile { "WhenDoingSupportFunctions.async.log" };
+        AsyncLog log(1024);
+        log.SetId(3);
+        LogSink sink;
+        auto opened = sink.Open(logFile);
+        sink.Attach(log);
+        char name[20] { "particle" };
+
+        // act
+        for (auto message = 0; message < 200; message++)
+        {
+            string text { std::to_string(message * 2) };
+            log.Write("Message {} of {} has {} and {}\n", message, name, text, message % 2 == 0);
+
+            // Give the sink time to drain, so the ring wraps many times.
+            if (message % 10 == 9)
+                std::this_thread::sleep_for(milliseconds(5));
+        }
+        sink.Close();
+
+        vector<string> lines;
+        std::ifstream file(logFile);
+        for (string line; std::getline(file, line); )
+            lines.push_back(line);
+        std::remove(logFile.c_str());
+
+        // assert
+        EXPECT_TRUE(opened);
+        EXPECT_FALSE(sink.Failed());
+        ASSERT_GE(lines.size(), 1);
+        EXPECT_EQ(lines[0], "3: Message 0 of particle has 0 and 1");
+        auto written = lines.size() - (log.Dropped() > 0 ? 1 : 0);
+        EXPECT_EQ(written + log.Dropped(), 200);
+        for (auto line = 1ULL; line < written; line++)
+            EXPECT_EQ(lines[line].find("3: Message "), 0);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, TelemetryIsReadAsAConsistentSnapshot)
+    {
+        // arrange
+        TelemetryChannel channel;
+        channel.Resize(8);
+        std::atomic<bool> done { false };
+        unsigned long long int reads { 0ULL };
+        unsigned long long int torn { 0ULL };
+        unsigned long long int lastTick { 0ULL };
+        auto reader = thread([&]()
+        {
+            EngineTelemetry telemetry {};
+            while (!done.load())
+            {
+                channel.Read(telemetry);
+                for (auto& worker : telemetry.Workers)
+                    if (worker.ItemsProcessed != telemetry.Engine.Tick || worker.WakeNanoseconds != telemetry.Engine.Tick * 3) torn++;
+                if (telemetry.Engine.Tick < lastTick) torn++;
+                lastTick = telemetry.Engine.Tick;
+                reads++;
+            }
+        });
+
+        // act
+        vector<WorkerTelemetry> workers(8);
+        for (auto tick = 1ULL; tick <= 200'000; tick++)
+        {
+            TickTelemetry engine {};
+            engine.Tick = tick;
+            for (auto& worker : workers)
+            {
+                worker.ItemsProcessed = tick;
+                worker.WakeNanoseconds = tick * 3;
+            }
+            channel.Publish(engine, workers.data(), workers.size());
+        }
+        done = true;
+        reader.join();
+
+        EngineTelemetry last {};
+        channel.Read(last);
+
+        // assert
+        EXPECT_GT(reads, 0);
+        EXPECT_EQ(torn, 0);
+        EXPECT_EQ(last.Engine.Tick, 200'000);
+        ASSERT_EQ(last.Workers.size(), 8);
+        EXPECT_EQ(last.Workers[7].ItemsProcessed, 200'000);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, BinaryRecordsConvertBackToTheSameCsv)
+    {
+        // arrange
+        string recordFile { "WhenDoingSupportFunctions.binary.csv" };
+        unsigned long long int ticks { 0ULL };
+        RecordWriter<TestColumnRecord> writer;
+        StreamingRecorder<TestColumnRecord> recorder(ticks);
+        auto opened = writer.Open(recordFile, RecordFormat::Binary);
+        recorder.Attach(writer, 4);
+        vector<string> expected { "Tick," + TestColumnRecord::Header() };
+
+        // act
+        for (ticks = 100; ticks < 110; ticks++)
+        {
+            TestColumnRecord record((ticks * 7919) % 1000, static_cast<int>(ticks) - 105);
+            expected.push_back(std::to_string(ticks) + "," + record.Format());
+            recorder.Record(record);
+        }
+        recorder.Flush();
+        writer.Close();
+
+        auto converted = BinaryRecordFormat<TestColumnRecord>::ConvertToCsv(writer.Path(), recordFile);
+        vector<string> lines;
+        std::ifstream file(recordFile);
+        for (string line; std::getline(file, line); )
+            lines.push_back(line);
+        std::remove(writer.Path().c_str());
+        std::remove(recordFile.c_str());
+
+        // assert
+        EXPECT_TRUE(opened);
+        EXPECT_EQ(writer.Format(), RecordFormat::Binary);
+        EXPECT_EQ(writer.Path(), "WhenDoingSupportFunctions.binary.rec");
+        EXPECT_TRUE(converted);
+        EXPECT_EQ(lines, expected);
+    }
+
+    TEST_F(WhenDoingSupportFunctions, IndexLayoutsStoreEveryCellInExactlyOneNode)
+    {
+        for (auto order : { IndexOrder::RowMajor, IndexOrder::ZOrder, IndexOrder::Hilbert })
+        {
+            // arrange
+            IndexLayout layout(13, 7, order);
+            vector<bool> stored(layout.Size(), false);
+            auto roundTrips { true };
+
+            // act
+            for (auto gridIndex = 0ULL; gridIndex < layout.Size(); gridIndex++)
+            {
+                auto storageIndex = layout.ToStorage(gridIndex);
+                if (storageIndex < stored.size()) stored[storageIndex] = true;
+                roundTrips &= layout.ToGrid(storageIndex) == gridIndex;
+            }
+
+            // assert
+            EXPECT_TRUE(roundTrips);
+            EXPECT_EQ(std::count(stored.begin(), stored.end(), true), 13 * 7);
+            EXPECT_EQ(layout.ToStorage(91), 91);
+            EXPECT_EQ(layout.ToStorage(3, 5), layout.ToStorage(3 * 13 + 5));
+            EXPECT_EQ(layout.Row(layout.ToStorage(3, 5)), 3);
+            EXPECT_EQ(layout.Column(layout.ToStorage(3, 5)), 5);
+        }
+    }
+
+    TEST_F(WhenDoingSupportFunctions, CurveLayoutsStoreTilesTogether)
+    {
+        // arrange
+        IndexLayout rowMajor(16, 16, IndexOrder::RowMajor);
+        IndexLayout zOrder(16, 16, IndexOrder::ZOrder);
+        IndexLayout hilbert(16, 16, IndexOrder::Hilbert);
+        auto zOrderTile { true };
+        auto hilbertTile { true };
+        auto hilbertSteps { true };
+
+        // act
+        for (auto storageIndex = 0ULL; storageIndex < 16; storageIndex++)
+        {
+            zOrderTile &= zOrder.Row(storageIndex) < 4 && zOrder.Column(storageIndex) < 4;
+            hilbertTile &= hilbert.Row(storageIndex) < 4 && hilbert.Column(storageIndex) < 4;
+        }
+        for (auto storageIndex = 1ULL; storageIndex < hilbert.Size(); storageIndex++)
+        {
+            auto rows = std::max(hilbert.Row(storageIndex), hilbert.Row(storageIndex - 1)) - std::min(hilbert.Row(storageIndex), hilbert.Row(storageIndex - 1));
+            auto columns = std::max(hilbert.Column(storageIndex), hilbert.Column(storageIndex - 1)) - std::min(hilbert.Column(storageIndex), hilbert.Column(storageIndex - 1));
+            hilbertSteps &= rows + columns == 1;
+        }
+
+        // assert
+        EXPECT_EQ(rowMajor.ToStorage(5, 9), 5 * 16 + 9);
+        EXPECT_EQ(zOrder.ToStorage(1, 0), 2);
+        EXPECT_EQ(zOrder.ToStorage(1, 1), 3);
+        EXPECT_TRUE(zOrderTile);
+        EXPECT_TRUE(hilbertTile);
+        EXPECT_TRUE(hilbertSteps);
+    }
 }
@@ -15,6 +15,8 @@
 #include "TestConfigurationRepository.h"
 #include "ModelEngineContextOp.h"
 #include "AdaptiveWidthPartitioner.h"
+#include "OwnerRoutedPartitioner.h"
+#include "CostWeightedPartitioner.h"
 
 namespace test::embeddedpenguins::modelengine::infrastructure
 {
@@ -70,15 +72,21 @@ namespace test::embeddedpenguins::modelengine::infrastructure
             context_(configuration_, helper_)
         {
             context_.WorkerCount = std::thread::hardware_concurrency() - 1;
+
+            // These tests look at the sparse work lists handed to workers.
+            context_.DenseFrontierFraction = 0.0;
         }
 
         ~WhenPartitioningWork() override { }
         void SetUp() override { }
         void TearDown() override
         {
-            Log::Merge(context_.Logger);
             cout << "Writing log file to " << context_.LogFile << "... " << std::flush;
-            Log::Print(context_.LogFile.c_str());
+            if (context_.LogWriter.Open(context_.LogFile))
+            {
+                context_.LogWriter.Attach(context_.Logger);
+                context_.LogWriter.Close();
+            }
             cout << "Done\n";
 
             for (auto& worker : context_.Workers)
@@ -99,7 +107,9 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         }
 
         vector<WorkItem<TestOperation>>& GetTotalSourceWork() { return totalSourceWork_; }
+        const unsigned long long int GetPendingFutureWork() const { return totalSourceWork_.size() + futureWork_.Size(); }
         vector<WorkItem<TestOperation>>& GetWorkForNextTick() { return workForNextTick_; };
+        vector<WorkItem<TestOperation>>& GetHandedOffWork() { return handedOffWork_; };
         const unsigned long int CollectedWorkForWorkers() const { return collectedWorkForWorkers_; }
         unsigned long int& CollectedWorkForWorkers() { return collectedWorkForWorkers_; }
 
@@ -163,6 +173,50 @@ namespace test::embeddedpenguins::modelengine::infrastructure
 
     };
 
+    // Protected internal state is exposed to this derived class.
+    class TestCostWeightedPartitioner : public CostWeightedPartitioner<TestOperation, TestImplementation, TestHelper, TestRecord>
+    {
+    public:
+        TestCostWeightedPartitioner(ModelEngineContext<TestOperation, TestImplementation, TestHelper, TestRecord>& context) :
+            CostWeightedPartitioner(context)
+        {
+            
+        }
+
+        vector<unsigned long long int>& Cut(vector<WorkItem<TestOperation>>& work)
+        {
+            FindSegmentEnds(work, segmentEnds_);
+            return segmentEnds_;
+        }
+
+        double SegmentCost(vector<WorkItem<TestOperation>>& work, unsigned long long int segmentBegin, unsigned long long int segmentEnd, double (*itemCost)(long long int))
+        {
+            auto cost { 0.0 };
+            for (auto position = segmentBegin; position < segmentEnd; position++)
+                cost += itemCost(work[position].Operator.Index);
+            return cost;
+        }
+
+        //
+        // Give each worker the time its last segment would take at the given
+        // cost per item, as if it had just processed it, and learn from that.
+        //
+        void LearnFrom(vector<WorkItem<TestOperation>>& work, double (*itemCost)(long long int))
+        {
+            auto segmentBegin { 0ULL };
+            for (auto workerIndex = 0ULL; workerIndex < context_.Workers.size(); workerIndex++)
+            {
+                auto& tally = context_.Workers[workerIndex]->GetContext().Tally;
+                auto cost = SegmentCost(work, segmentBegin, segmentEnds_[workerIndex], itemCost);
+                tally.WakeTime = Clock::now();
+                tally.ProcessEndTime = tally.WakeTime + std::chrono::nanoseconds(static_cast<long long int>(cost));
+                segmentBegin = segmentEnds_[workerIndex];
+            }
+
+            LearnFromLastTick();
+        }
+    };
+
     TEST_F(WhenPartitioningWork, PastWorkIsDone)
     {
         // Arrange
@@ -173,7 +227,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         partitioner.Partition();
 
         // Assert
-        EXPECT_EQ(partitioner.GetTotalSourceWork().size(), 0);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), 0);
     }
 
     TEST_F(WhenPartitioningWork, FutureWorkIsLeft)
@@ -186,7 +240,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         partitioner.Partition();
 
         // Assert
-        EXPECT_EQ(partitioner.GetTotalSourceWork().size(), std::thread::hardware_concurrency() - 1);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), std::thread::hardware_concurrency() - 1);
     }
 
     TEST_F(WhenPartitioningWork, PastWorkIsPartitionedCorrectly)
@@ -200,7 +254,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         partitioner.Partition(now_ + 11);
 
         // Assert
-        EXPECT_EQ(partitioner.GetTotalSourceWork().size(), 0);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), 0);
         for (auto& worker : context_.Workers)
             EXPECT_EQ(worker->GetContext().WorkForThread.size(), 1);
     }
@@ -216,7 +270,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         partitioner.Partition(now_ + 11);
 
         // Assert
-        EXPECT_EQ(partitioner.GetTotalSourceWork().size(), 0);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), 0);
         for (auto& worker : context_.Workers)
             EXPECT_EQ(worker->GetContext().WorkForThread.size(), 1);
     }
@@ -233,7 +287,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         partitioner.Partition(now_ + 11);
 
         // Assert
-        EXPECT_EQ(partitioner.GetTotalSourceWork().size(), 0);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), 0);
         for (auto& worker : context_.Workers)
         {
             if (worker->GetContext().WorkerId == 1)
@@ -243,6 +297,45 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         }
     }
 
+    TEST_F(WhenPartitioningWork, StolenChunksNeverSplitAnIndex)
+    {
+        // Arrange
+        context_.WorkStealing = true;
+        context_.ChunksPerWorker = 4;
+        ModelEngineContextOp<TestOperation, TestImplementation, TestHelper, TestRecord>(context_).CreateWorkers(helper_);
+        TestAdaptiveWidthPartitioner partitioner(context_);
+        partitioner.LoadWorkWithConsecutiveIndexes(std::thread::hardware_concurrency() - 1, now_ + 10);
+        partitioner.AddWorkWithSameIndex(1, now_ + 10, 9);
+        partitioner.AddWorkWithSameIndex(2, now_ + 10, 3);
+
+        // Act
+        partitioner.Partition(now_ + 11);
+
+        // Assert
+        EXPECT_EQ(context_.Workers.front()->GetContext().WorkForThread.size(), 10);
+        EXPECT_EQ(context_.Workers.front()->GetContext().Chunks.ChunkCount(), 1);
+        for (auto& worker : context_.Workers)
+        {
+            auto& workerContext = worker->GetContext();
+            auto& work = workerContext.WorkForThread;
+            EXPECT_EQ(workerContext.StealFrom.size(), context_.Workers.size() - 1);
+
+            unsigned long long int expectedBegin { 0ULL };
+            for (auto chunk = 0ULL; chunk < workerContext.Chunks.ChunkCount(); chunk++)
+            {
+                auto& range = workerContext.Chunks[chunk];
+                EXPECT_EQ(range.first, expectedBegin);
+                EXPECT_LT(range.first, range.second);
+                if (range.first > 0)
+                {
+                    EXPECT_NE(work[range.first - 1].Operator.Index, work[range.first].Operator.Index);
+                }
+                expectedBegin = range.second;
+            }
+            EXPECT_EQ(expectedBegin, work.size());
+        }
+    }
+
     TEST_F(WhenPartitioningWork, PastOddWorkIsPartitionedCorrectly)
     {
         // Arrange
@@ -257,7 +350,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         partitioner.Partition(now_ + 11);
 
         // Assert
-        EXPECT_EQ(partitioner.GetTotalSourceWork().size(), 0);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), 0);
         EXPECT_EQ(context_.Workers.size(), std::thread::hardware_concurrency() - 1);
         for (auto& worker : context_.Workers)
         {
@@ -368,6 +461,34 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         }
     }
 
+    TEST_F(WhenPartitioningWork, WorkIsHandedOffWithoutCopying)
+    {
+        // Arrange
+        ModelEngineContextOp<TestOperation, TestImplementation, TestHelper, TestRecord>(context_).CreateWorkers(helper_);
+        TestAdaptiveWidthPartitioner partitioner(context_);
+        for (auto& worker : context_.Workers)
+            for (int i = 0; i < context_.Workers.size(); i++)
+                worker->GetContext().WorkForTick1.push_back(WorkItem<TestOperation> { now_, TestOperation(i + 1) });
+
+        // Act
+        partitioner.Partition(now_ + 1);
+        partitioner.LoadWorkWithConsecutiveIndexes(100, now_ + 1);
+        partitioner.ConcurrentPartitionStep();
+
+        // Assert
+        auto& handedOffWork = partitioner.GetHandedOffWork();
+        ASSERT_EQ(handedOffWork.size(), context_.Workers.size() * context_.Workers.size());
+        for (auto& worker : context_.Workers)
+        {
+            auto& workForThread = worker->GetContext().WorkForThread;
+            ASSERT_FALSE(workForThread.empty());
+            EXPECT_GE(&workForThread.front(), &handedOffWork.front());
+            EXPECT_LE(&workForThread.back(), &handedOffWork.back());
+            for (auto& work : workForThread)
+                EXPECT_EQ(work.Operator.Index, worker->GetContext().WorkerId);
+        }
+    }
+
     TEST_F(WhenPartitioningWork, DuplicateTimesAreAllowed)
     {
         // Arrange
@@ -403,4 +524,119 @@ namespace test::embeddedpenguins::modelengine::infrastructure
         EXPECT_EQ(totalWork, expectedWorkItemCount);
         EXPECT_EQ(partitioner.CollectedWorkForWorkers(), expectedWorkItemCount);
     }
+
+    TEST_F(WhenPartitioningWork, LongDelayWorkIsDoneOnTime)
+    {
+        // Arrange
+        ModelEngineContextOp<TestOperation, TestImplementation, TestHelper, TestRecord>(context_).CreateWorkers(helper_);
+        TestAdaptiveWidthPartitioner partitioner(context_);
+        partitioner.AddWorkWithSameIndex(1, now_ + 300, 1);
+        partitioner.AddWorkWithSameIndex(2, now_ + 70'000, 1);
+
+        // Act
+        partitioner.Partition(now_ + 300);
+        auto pendingBefore = partitioner.GetPendingFutureWork();
+        partitioner.CollectedWorkForWorkers() = 0;
+        partitioner.Partition(1);
+        auto collectedAtFirstTick = partitioner.CollectedWorkForWorkers();
+        partitioner.Partition(70'000 - 301);
+        auto pendingAfter = partitioner.GetPendingFutureWork();
+        partitioner.CollectedWorkForWorkers() = 0;
+        partitioner.Partition(1);
+
+        // Assert
+        EXPECT_EQ(pendingBefore, 2);
+        EXPECT_EQ(collectedAtFirstTick, 1);
+        EXPECT_EQ(pendingAfter, 1);
+        EXPECT_EQ(partitioner.CollectedWorkForWorkers(), 1);
+        EXPECT_EQ(partitioner.GetPendingFutureWork(), 0);
+    }
+
+    TEST_F(WhenPartitioningWork, RoutedWorkReachesOwningWorker)
+    {
+        // Arrange
+        context_.Partitioning = PartitionPolicy::OwnerRouted;
+        helper_.AllocateModel();
+        ModelEngineContextOp<TestOperation, TestImplementation, TestHelper, TestRecord>(context_).CreateWorkers(helper_);
+        OwnerRoutedPartitioner<TestOperation, TestImplementation, TestHelper, TestRecord> partitioner(context_);
+        auto modelSize = helper_.Model().ModelSize();
+        auto expectedWorkItemCount {0UL};
+        for (auto& worker : context_.Workers)
+        {
+            ProcessCallback<TestOperation, TestRecord> callback(worker->GetContext());
+            for (auto index = 0UL; index < modelSize; index += 997)
+            {
+                callback(TestOperation(index));
+                expectedWorkItemCount++;
+            }
+            callback(TestOperation(modelSize - 1), 2);
+            expectedWorkItemCount++;
+        }
+
+        // Act
+        partitioner.ConcurrentPartitionStep();
+        auto totalWork = partitioner.SingleThreadPartitionStep();
+        for (auto& worker : context_.Workers)
+            worker->GetContext().CurrentBuffer = CurrentBufferType::Buffer2Current;
+        ++context_.Iterations;
+        partitioner.ConcurrentPartitionStep();
+        totalWork += partitioner.SingleThreadPartitionStep();
+
+        // Assert
+        EXPECT_EQ(totalWork, expectedWorkItemCount);
+        for (auto& worker : context_.Workers)
+        {
+            auto& workerContext = worker->GetContext();
+            for (auto& work : workerContext.WorkForThread)
+            {
+                EXPECT_GE(work.Operator.Index, workerContext.RangeBegin);
+                EXPECT_LT(work.Operator.Index, workerContext.RangeEnd);
+            }
+        }
+        EXPECT_EQ(context_.Workers.back()->GetContext().WorkForThread.size(), context_.Workers.size());
+    }
+
+    TEST_F(WhenPartitioningWork, CostWeightedSegmentsLearnToBalanceCost)
+    {
+        // Arrange
+        context_.Partitioning = PartitionPolicy::CostWeighted;
+        helper_.AllocateModel();
+        ModelEngineContextOp<TestOperation, TestImplementation, TestHelper, TestRecord>(context_).CreateWorkers(helper_);
+        TestCostWeightedPartitioner partitioner(context_);
+        auto modelSize = helper_.Model().ModelSize();
+        vector<WorkItem<TestOperation>> work;
+        for (auto index = 0ULL; index < modelSize; index += 101)
+            work.push_back(WorkItem<TestOperation> { now_, TestOperation(index) });
+
+        // Work in the first quarter of the model costs ten times as much as the rest.
+        auto itemCost = [](long long int index) -> double { return index < 250'000 ? 10'000.0 : 1'000.0; };
+        auto totalCost = partitioner.SegmentCost(work, 0, work.size(), itemCost);
+        auto workerCount = context_.Workers.size();
+
+        // Act
+        auto& firstEnds = partitioner.Cut(work);
+        auto firstCountOfFirstSegment = firstEnds[0];
+        for (auto _ = 0; _ < 200; _++)
+        {
+            partitioner.LearnFrom(work, itemCost);
+            partitioner.Cut(work);
+        }
+        auto& segmentEnds = partitioner.Cut(work);
+
+        // Assert
+        ASSERT_EQ(segmentEnds.size(), workerCount);
+        EXPECT_EQ(segmentEnds.back(), work.size());
+        EXPECT_GT(partitioner.RegionCost(0), partitioner.RegionCost(DefaultCostRegions - 1));
+        if (workerCount > 1)
+        {
+            EXPECT_LT(segmentEnds[0], firstCountOfFirstSegment);
+        }
+
+        auto segmentBegin { 0ULL };
+        for (auto segmentEnd : segmentEnds)
+        {
+            EXPECT_NEAR(partitioner.SegmentCost(work, segmentBegin, segmentEnd, itemCost), totalCost / workerCount, totalCost / workerCount * 0.1 + 10'000.0);
+            segmentBegin = segmentEnd;
+        }
+    }
 }
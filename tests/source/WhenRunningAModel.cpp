@@ -1,5 +1,6 @@
 #include <memory>
 #include <chrono>
+#include <algorithm>
 
 #include "nlohmann/json.hpp"
 
@@ -8,10 +9,12 @@
 
 #include "TestConfigurationRepository.h"
 #include "ModelEngine.h"
+#include "CpuPlacement.h"
 #include "TestNode.h"
 #include "TestOperation.h"
 #include "TestImplementation.h"
 #include "TestIdleImplementation.h"
+#include "TestSparseImplementation.h"
 #include "TestModelCarrier.h"
 #include "TestHelper.h"
 
@@ -31,6 +34,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
 
   //using ::embeddedpenguins::core::neuron::model::ConfigurationRepository;
   using ::embeddedpenguins::modelengine::ModelEngine;
+  using ::embeddedpenguins::modelengine::threads::CpuPlacement;
 
   constexpr unsigned long long int modelSize_ = 5'000;
   string TestConfigurationWhenRunningAModel = "\
@@ -97,6 +101,20 @@ namespace test::embeddedpenguins::modelengine::infrastructure
       duration_ = nanoseconds::min();
     }
 
+    // The engine starts a worker on every usable cpu but the one it runs on, and at least one.
+    int DefaultWorkerCount() const
+    {
+      auto usableCpus = static_cast<int>(CpuPlacement::UsableCpus({ }, false).size());
+      return std::max(1, usableCpus - 1);
+    }
+
+    // Each worker given work signals 7 work items, and a tick's work is spread
+    // over 7 indexes, so at most 7 workers are given work in a tick.
+    unsigned long long int WorkPerTick() const
+    {
+      return 7ULL * std::min(modelEngine_->GetWorkerCount(), 7);
+    }
+
     void SetModelEngine(unique_ptr<ModelEngine<TestOperation, TestImplementation, TestHelper, TestRecord>>& modelEngine)
     {
       modelEngine_.reset();
@@ -134,8 +152,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
     RunStopModelEngine();
 
     // Assert
-    auto coreCount = std::thread::hardware_concurrency();
-    EXPECT_EQ(modelEngine_->GetWorkerCount(), coreCount - 1);
+    EXPECT_EQ(modelEngine_->GetWorkerCount(), DefaultWorkerCount());
   }
 
   TEST_F(WhenRunningAModel, ModelEngineStoppedReturnsZeroIterations)
@@ -160,7 +177,7 @@ namespace test::embeddedpenguins::modelengine::infrastructure
 
     // Assert
     auto iterations = modelEngine_->GetIterations();
-    EXPECT_EQ(modelEngine_->GetTotalWork(), iterations*49);
+    EXPECT_EQ(modelEngine_->GetTotalWork(), iterations * WorkPerTick());
   }
 
   TEST_F(WhenRunningAModel, ModelEngineRunsWithIdleCycles)
@@ -201,7 +218,204 @@ namespace test::embeddedpenguins::modelengine::infrastructure
 
     // Assert
     auto iterations = modelEngine_->GetIterations();
-    EXPECT_EQ(modelEngine_->GetTotalWork(), (iterations - 2) * 49 + 1 + 7);
+    EXPECT_EQ(modelEngine_->GetTotalWork(), (iterations - 2) * WorkPerTick() + 1 + 7);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineReturnsCorrectWorkItemsWhenStealing)
+  {
+    // Arrange
+    SetConfiguredModelTicks(1000);
+    configuration_.Configuration()["Execution"]["WorkStealing"] = true;
+    // Each chunk is processed in its own Process() call, which signals 7 work items,
+    // so keep one chunk per worker for the work per tick not to depend on the cpu count.
+    configuration_.Configuration()["Execution"]["ChunksPerWorker"] = 1U;
+    SetModelEngine(5'000);
+
+    // Act
+    RunModelEngine(50);
+
+    // Assert
+    auto iterations = modelEngine_->GetIterations();
+    EXPECT_EQ(modelEngine_->GetTotalWork(), (iterations - 2) * WorkPerTick() + 1 + 7);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineReturnsCorrectWorkItemsWhenCostWeighted)
+  {
+    // Arrange
+    configuration_.Configuration()["Execution"]["PartitionPolicy"] = "CostWeighted";
+    configuration_.Configuration()["Execution"]["CostRegions"] = 16U;
+    SetModelEngine(5'000);
+
+    // Act
+    modelEngine_->RunTicks(500);
+
+    // Assert
+    EXPECT_EQ(modelEngine_->GetIterations(), 500);
+    EXPECT_EQ(modelEngine_->GetTotalWork(), (500 - 2) * WorkPerTick() + 1 + 7);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineReturnsCorrectWorkItemsWhenDense)
+  {
+    // Arrange
+    // The test model has a million nodes; go dense once a tick has 5 items.
+    configuration_.Configuration()["Execution"]["DenseFrontierFraction"] = 0.000005;
+    SetModelEngine(5'000);
+
+    // Act
+    modelEngine_->RunTicks(500);
+
+    // Assert
+    EXPECT_EQ(modelEngine_->GetIterations(), 500);
+    EXPECT_EQ(modelEngine_->GetTotalWork(), (500 - 2) * WorkPerTick() + 1 + 7);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineRunsExactlyTheTickBudget)
+  {
+    // Arrange
+    SetModelEngine(5'000);
+
+    // Act
+    modelEngine_->RunTicks(500);
+
+    // Assert
+    EXPECT_EQ(modelEngine_->GetIterations(), 500);
+    EXPECT_EQ(modelEngine_->GetTotalWork(), (500 - 2) * WorkPerTick() + 1 + 7);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEnginePublishesTelemetryForTheLastTick)
+  {
+    // Arrange
+    SetModelEngine(5'000);
+
+    // Act
+    modelEngine_->RunTicks(500);
+    auto telemetry = modelEngine_->GetTelemetry();
+
+    // Assert
+    unsigned long long int itemsProcessed { 0ULL };
+    for (auto& worker : telemetry.Workers)
+      itemsProcessed += worker.ItemsProcessed;
+    EXPECT_EQ(telemetry.Engine.Tick, 500);
+    EXPECT_EQ(telemetry.Engine.TotalWork, modelEngine_->GetTotalWork());
+    EXPECT_EQ(telemetry.Workers.size(), modelEngine_->GetWorkerCount());
+    EXPECT_EQ(telemetry.Engine.ItemsProcessed, WorkPerTick());
+    EXPECT_EQ(itemsProcessed, WorkPerTick());
+    EXPECT_GT(telemetry.Engine.ItemsEmitted, 0);
+    EXPECT_GT(telemetry.Engine.TickNanoseconds, 0);
+    EXPECT_GE(telemetry.Engine.LoadImbalance, 1.0);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineStopsWhenIdle)
+  {
+    // Arrange
+    ModelEngine<TestOperation, TestIdleImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+
+    // Act
+    modelEngine.RunTicks(1'000, true);
+
+    // Assert
+    EXPECT_EQ(modelEngine.GetTotalWork(), 1);
+    EXPECT_EQ(modelEngine.GetIterations(), 2);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineSkipsIdleTicks)
+  {
+    // Arrange
+    configuration_.Configuration()["Execution"]["WaitPolicy"] = "FirstWork";
+    ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+
+    // Act
+    modelEngine.RunTicks(4'500);
+
+    // Assert
+    // Work is done in ticks 1000, 2000, 3000 and 4000, with the next already partitioned.
+    EXPECT_EQ(modelEngine.GetIterations(), 4'500);
+    EXPECT_EQ(modelEngine.GetTotalWork(), 4);
+    EXPECT_EQ(GetModel()[1].Data, 4'000);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineRestoresFromSnapshot)
+  {
+    // Arrange
+    string snapshotFile { "WhenRunningAModel.snapshot" };
+    {
+      ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+      modelEngine.RunTicks(1'500);
+      GetModel()[2].Data = 77;
+      ASSERT_TRUE(modelEngine.Snapshot(snapshotFile));
+    }
+    std::fill(begin(GetModel()), end(GetModel()), TestNode { });
+
+    // Act
+    ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+    modelEngine.RestoreFile(snapshotFile);
+    modelEngine.RunTicks(3'000);
+    std::remove(snapshotFile.c_str());
+
+    // Assert
+    // The work scheduled before the snapshot carries on in ticks 2000, 3000 and 4000.
+    // The restarted input stream adds work in ticks 2500 and 3500.
+    EXPECT_EQ(modelEngine.GetIterations(), 4'500);
+    EXPECT_EQ(GetModel()[1].Data, 4'000);
+    EXPECT_EQ(GetModel()[2].Data, 77);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineRestoresFromIncrementalCheckpoints)
+  {
+    // Arrange
+    string checkpointFile { "WhenRunningAModel.checkpoint" };
+    {
+      ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+      modelEngine.CheckpointFile(checkpointFile);
+      modelEngine.CheckpointInterval(100);
+      modelEngine.CheckpointCompactAfter(4);
+      modelEngine.RunTicks(1'500);
+    }
+    std::fill(begin(GetModel()), end(GetModel()), TestNode { });
+
+    // Act
+    ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+    modelEngine.RestoreFile(checkpointFile);
+    modelEngine.RunTicks(400);
+    std::remove(checkpointFile.c_str());
+    for (auto sequence = 1; sequence <= 14; sequence++)
+      std::remove((checkpointFile + ".delta." + std::to_string(sequence)).c_str());
+
+    // Assert
+    // Every fourth delta is compacted into the base, so the work done in tick 1000 is restored
+    // from the compacted base, and the deltas written after it bring the model up to tick 1500.
+    EXPECT_EQ(modelEngine.GetIterations(), 1'900);
+    EXPECT_EQ(GetModel()[1].Data, 1'000);
+  }
+
+  TEST_F(WhenRunningAModel, ModelEngineWritesCheckpointsInTheForeground)
+  {
+    // Arrange
+    string checkpointFile { "WhenRunningAModel.foreground.checkpoint" };
+    unsigned long long int checkpoints { 0ULL };
+    {
+      ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+      modelEngine.CheckpointFile(checkpointFile);
+      modelEngine.CheckpointInterval(100);
+      modelEngine.CheckpointInBackground(false);
+      modelEngine.RunTicks(1'500);
+      checkpoints = modelEngine.GetCheckpoints();
+      EXPECT_GE(modelEngine.GetCheckpointStallTime(), modelEngine.GetCheckpointStallMax());
+    }
+    std::fill(begin(GetModel()), end(GetModel()), TestNode { });
+
+    // Act
+    ModelEngine<TestOperation, TestSparseImplementation, TestHelper, TestRecord> modelEngine(helper_, configuration_);
+    modelEngine.RestoreFile(checkpointFile);
+    modelEngine.RunTicks(400);
+    std::remove(checkpointFile.c_str());
+    for (auto sequence = 1; sequence <= 14; sequence++)
+      std::remove((checkpointFile + ".delta." + std::to_string(sequence)).c_str());
+
+    // Assert
+    EXPECT_EQ(checkpoints, 15);
+    EXPECT_EQ(modelEngine.GetIterations(), 1'900);
+    EXPECT_EQ(GetModel()[1].Data, 1'000);
   }
 
   TEST_F(WhenRunningAModel, ModelEngineTakesCorrectDuration)